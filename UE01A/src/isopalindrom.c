@@ -6,74 +6,875 @@
  * @brief A Program, which checks whether strings are palindroms
  */
 
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD
+#endif
 #include "isopalindrom.h"
 
+#define OUT_BUF_SIZE (1 << 20)	// bytes of output collected before they are written
+#define OUT_IOV 1024			// max. number of parts written with a single writev
+#define OUT_REF_MIN 4096		// lines this long are written directly from the input instead of being copied
+#define CHUNK_SIZE (4 << 20)	// min. bytes of input checked by a thread at once, chunks end at a line
+#define CHUNK_WINDOW 4			// chunks per thread, which may be checked ahead of the output
+#define MAX_THREADS 256			// max. number of threads
+#define INVALID_BYTE 0x110000	// bytes, which aren't valid UTF-8, are decoded as INVALID_BYTE + byte
+
+/** signature of the palindrom kernels, which check str[0..len) from both ends */
+typedef int (*palindrom_kernel)(const char *str, size_t len, int ignore_case, int ignore_whitespaces, int utf8);
+
+/** output collected in memory, which is written with writev */
+typedef struct out_buffer {
+	int fd;							/** file the output is written to, -1 if it is only collected in buf */
+	char *buf;						/** copied parts of the output */
+	size_t len;						/** number of bytes in buf */
+	size_t cap;						/** size of buf, which grows if the output is only collected */
+	struct iovec *iov;				/** the parts of the output in order, pointing into buf or the input */
+	int iovcnt;						/** number of parts in iov */
+	int iovcap;						/** size of iov, which grows if the output is only collected */
+} out_buffer;
+
+/** a line-aligned part of a mapped input file, checked by one thread */
+typedef struct chunk {
+	const char *data;				/** first line of the chunk */
+	size_t size;					/** number of bytes in data */
+	int done;						/** set once the chunk is checked */
+} chunk;
+
+/** the chunks shared by the threads, they are checked in order and written in order */
+typedef struct chunk_queue {
+	chunk *chunks;					/** all chunks in input order */
+	int count;						/** number of chunks */
+	int next;						/** next chunk to be checked */
+	int written;					/** number of chunks already written */
+	int window;						/** max. number of chunks checked ahead of the output */
+	out_buffer *slots;				/** output of chunk k is collected in slot k % window, reused once it is written */
+	const check_options *opts;		/** how the lines are checked */
+	pthread_mutex_t lock;			/** protects next, written and done */
+	pthread_cond_t changed;			/** signals a checked or a written chunk */
+} chunk_queue;
+
+/** a mapped input file */
+typedef struct mapping {
+	char *data;						/** the mapped file, NULL if it is empty */
+	size_t size;					/** size of the file */
+} mapping;
+
+static void search_line(const char *str, size_t len, out_buffer *o, const check_options *opts);
+
 /**
  * Prints the correct usage of the Programm
  * 
  * @param pname The path and name of the executed programm
  */
 static void usage(char* pname) {
-	fprintf(stderr, "Usage: %s [-s] [-i] [-o outfile] [file...]\n\t-s ignore whitespaces\n\t-i igonre upper/lowercase\n\t-o write output to specified file\n", pname);
+	fprintf(stderr, "Usage: %s [-s] [-i] [-u] [-l | -m length] [-j threads] [-o outfile] [file...]\n\t-s ignore whitespaces\n\t-i igonre upper/lowercase\n\t-u compare UTF-8 characters instead of bytes\n\t-l print the longest palindrom of each line\n\t-m print the offset and length of all maximal palindroms with at least length characters\n\t-j check regular files with multiple threads\n\t-o write output to specified file\n", pname);
 	exit(EXIT_FAILURE);
 }
 
+/**
+ * Allocates an empty output buffer
+ *
+ * @param o the output buffer
+ * @param fd file the output is written to, -1 to only collect it
+ * @param cap initial size of the buffer
+ * @return 0 on success, -1 if no memory is available
+ */
+static int out_init(out_buffer *o, int fd, size_t cap) {
+	o->fd = fd;
+	o->len = 0;
+	o->cap = cap;
+	o->iovcnt = 0;
+	o->iovcap = OUT_IOV;
+	if ((o->buf = malloc(cap)) == NULL) return -1;
+	if ((o->iov = malloc(OUT_IOV * sizeof(struct iovec))) == NULL) {
+		free(o->buf);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Frees the memory of an output buffer
+ */
+static void out_free(out_buffer *o) {
+	free(o->buf);
+	free(o->iov);
+	o->buf = NULL;
+	o->iov = NULL;
+}
+
+/**
+ * Writes the collected output and empties the buffer, exits if the output can't be written
+ *
+ * @param o the output buffer
+ * @param fd the file written to
+ */
+static void out_write(out_buffer *o, int fd) {
+	struct iovec *iov = o->iov;
+	int cnt = o->iovcnt;
+	char *copied = o->buf;
+	for (int i = 0; i < cnt; i++) {
+		if (iov[i].iov_base == NULL) { // a copied part of a collected output
+			iov[i].iov_base = copied;
+			copied += iov[i].iov_len;
+		}
+	}
+	while (cnt > 0) {
+		ssize_t n = writev(fd, iov, cnt < OUT_IOV ? cnt : OUT_IOV);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			fprintf(stderr, "Can't write output: %s\n", strerror(errno));
+			exit(1);
+		}
+		while (cnt > 0 && (size_t)n >= iov->iov_len) { // skip the parts written completely
+			n -= iov->iov_len;
+			iov++;
+			cnt--;
+		}
+		if (cnt > 0) {
+			iov->iov_base = (char*)iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+	o->len = 0;
+	o->iovcnt = 0;
+}
+
+/**
+ * Returns an unused part of the output, the output is written or grows if all parts are used
+ */
+static struct iovec *out_part(out_buffer *o) {
+	if (o->iovcnt == o->iovcap) {
+		if (o->fd >= 0) {
+			out_write(o, o->fd);
+		} else {
+			struct iovec *iov = realloc(o->iov, 2 * o->iovcap * sizeof(struct iovec));
+			if (iov == NULL) {
+				fprintf(stderr, "Out of memory!\n");
+				exit(1);
+			}
+			o->iov = iov;
+			o->iovcap *= 2;
+		}
+	}
+	return &o->iov[o->iovcnt++];
+}
+
+/**
+ * Appends a copy of data to the output. While the output is only collected,
+ * buf may still move, so copied parts are stored without a base until the
+ * output is written.
+ */
+static void out_copy(out_buffer *o, const char *data, size_t len) {
+	if (len > o->cap - o->len) {
+		if (o->fd >= 0) {
+			out_write(o, o->fd);
+		} else {
+			size_t cap = o->cap * 2 > o->len + len ? o->cap * 2 : o->len + len;
+			char *buf = realloc(o->buf, cap);
+			if (buf == NULL) {
+				fprintf(stderr, "Out of memory!\n");
+				exit(1);
+			}
+			o->buf = buf;
+			o->cap = cap;
+		}
+	}
+	struct iovec *last = o->iov + o->iovcnt - 1;
+	if (o->iovcnt > 0 && (o->fd < 0 ? last->iov_base == NULL : (char*)last->iov_base + last->iov_len == o->buf + o->len)) {
+		last->iov_len += len; // continues the last copied part
+	} else {
+		struct iovec *part = out_part(o);
+		part->iov_base = o->fd < 0 ? NULL : o->buf + o->len;
+		part->iov_len = len;
+	}
+	memcpy(o->buf + o->len, data, len);
+	o->len += len;
+}
+
+/**
+ * Appends data to the output without copying it, data has to stay valid until the output is written
+ */
+static void out_ref(out_buffer *o, const char *data, size_t len) {
+	struct iovec *part = out_part(o);
+	part->iov_base = (void*)data;
+	part->iov_len = len;
+}
+
+/**
+ * Checks a single line, or searches it for palindroms, and collects the result in the output
+ *
+ * @param str the line without the newline
+ * @param len number of bytes in str
+ * @param o the output buffer
+ * @param opts how the line is checked
+ */
+static void check_line(const char *str, size_t len, out_buffer *o, const check_options *opts) {
+	if (opts->longest || opts->min_length > 0) {
+		search_line(str, len, o, opts);
+		return;
+	}
+	if (len >= OUT_REF_MIN) out_ref(o, str, len);
+	else out_copy(o, str, len);
+	if (is_palindrom(str, len, opts->ignore_case, opts->ignore_whitespaces, opts->utf8)) out_copy(o, " is a palindrom\n", 16);
+	else out_copy(o, " is not a palindrom\n", 20);
+}
+
+/**
+ * Checks all lines of a buffer and collects the results in the output
+ *
+ * @param data the lines, separated by '\n'
+ * @param size number of bytes in data
+ * @param o the output buffer
+ * @param opts how the lines are checked
+ */
+static void check_lines(const char *data, size_t size, out_buffer *o, const check_options *opts) {
+	const char *p = data, *end = data + size;
+	while (p < end) {
+		const char *nl = memchr(p, '\n', end - p);
+		size_t n = (nl ? nl : end) - p;
+		check_line(p, n, o, opts);
+		p = nl ? nl + 1 : end;
+	}
+}
+
+/**
+ * Maps a regular input file into memory
+ *
+ * @param infile the input file
+ * @param m the mapping, which is set on success
+ * @return 0 on success, -1 if the file can't be mapped (e.g. a pipe)
+ */
+static int map_file(FILE *infile, mapping *m) {
+	int fd = fileno(infile);
+	struct stat st;
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || lseek(fd, 0, SEEK_CUR) != 0) return -1;
+	m->data = NULL;
+	m->size = st.st_size;
+	if (m->size == 0) return 0;
+
+	m->data = mmap(NULL, m->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (m->data == MAP_FAILED) return -1;
+	madvise(m->data, m->size, MADV_SEQUENTIAL);
+	return 0;
+}
+
+/**
+ * Checks a regular file in place by mapping it into memory
+ *
+ * @param infile the input file
+ * @param o the output buffer
+ * @param opts how the lines are checked
+ * @return 0 if the file has been checked, -1 if it can't be mapped (e.g. a pipe)
+ */
+static int check_mapped(FILE *infile, out_buffer *o, const check_options *opts) {
+	mapping m;
+	if (map_file(infile, &m) < 0) return -1;
+	if (m.size == 0) return 0;
+
+	check_lines(m.data, m.size, o, opts);
+	out_write(o, o->fd); // long lines are written directly from the mapping
+	munmap(m.data, m.size);
+	return 0;
+}
+
+/**
+ * Checks chunks of the queue until all of them are taken, never more than
+ * the window ahead of the output
+ *
+ * @param arg the chunk_queue
+ * @return always NULL
+ */
+static void *check_worker(void *arg) {
+	chunk_queue *q = arg;
+	pthread_mutex_lock(&q->lock);
+	while (q->next < q->count) {
+		if (q->next >= q->written + q->window) {
+			pthread_cond_wait(&q->changed, &q->lock);
+			continue;
+		}
+		out_buffer *out = &q->slots[q->next % q->window];
+		chunk *c = &q->chunks[q->next++];
+		pthread_mutex_unlock(&q->lock);
+
+		if (out->buf == NULL && out_init(out, -1, c->size / 2 + 4096) < 0) {
+			fprintf(stderr, "Out of memory!\n");
+			exit(1);
+		}
+		check_lines(c->data, c->size, out, q->opts);
+
+		pthread_mutex_lock(&q->lock);
+		c->done = 1;
+		pthread_cond_broadcast(&q->changed);
+	}
+	pthread_mutex_unlock(&q->lock);
+	return NULL;
+}
+
+/**
+ * Checks consecutive regular files with multiple threads. The files are split
+ * into line-aligned chunks, every chunk is checked into its own buffer and the
+ * buffers are written in input order, so the output equals a serial run.
+ *
+ * @param infiles the remaining input files
+ * @param in_len the number of remaining input files
+ * @param o the output buffer of the file written to
+ * @param opts how the lines are checked
+ * @param threads number of threads checking the chunks
+ * @return number of files checked, 0 if the first file can't be mapped or no thread can be started
+ */
+static int check_parallel(FILE **infiles, int in_len, out_buffer *o, const check_options *opts, int threads) {
+	mapping *maps = malloc(in_len * sizeof(mapping));
+	if (maps == NULL) return 0;
+	int files = 0, checked = 0;
+	size_t count = 0;
+	while (files < in_len && map_file(infiles[files], &maps[files]) == 0) {
+		count += maps[files].size / CHUNK_SIZE + 1;
+		files++;
+	}
+
+	chunk_queue q;
+	memset(&q, 0, sizeof(q));
+	pthread_t *tids = malloc(threads * sizeof(pthread_t));
+	q.window = CHUNK_WINDOW * threads;
+	if (files == 0 || tids == NULL || (q.chunks = calloc(count, sizeof(chunk))) == NULL ||
+			(q.slots = calloc(q.window, sizeof(out_buffer))) == NULL) goto cleanup;
+
+	/* split the files at the first line end after every CHUNK_SIZE bytes */
+	for (int i = 0; i < files; i++) {
+		const char *p = maps[i].data, *end = p + maps[i].size;
+		while (p < end) {
+			const char *stop = end;
+			if ((size_t)(end - p) > CHUNK_SIZE) {
+				const char *nl = memchr(p + CHUNK_SIZE, '\n', end - p - CHUNK_SIZE);
+				if (nl) stop = nl + 1;
+			}
+			q.chunks[q.count].data = p;
+			q.chunks[q.count++].size = stop - p;
+			p = stop;
+		}
+	}
+	q.opts = opts;
+	pthread_mutex_init(&q.lock, NULL);
+	pthread_cond_init(&q.changed, NULL);
+
+	int started = 0;
+	while (started < threads && started < q.count && pthread_create(&tids[started], NULL, check_worker, &q) == 0) started++;
+	if (started > 0 || q.count == 0) { // otherwise the files are checked serially by the caller
+		checked = files;
+		out_write(o, o->fd); // the results of previous inputs come first
+		for (int k = 0; k < q.count; k++) {
+			pthread_mutex_lock(&q.lock);
+			while (!q.chunks[k].done) pthread_cond_wait(&q.changed, &q.lock);
+			pthread_mutex_unlock(&q.lock);
+
+			out_write(&q.slots[k % q.window], o->fd); // long lines are written directly from the mappings
+
+			pthread_mutex_lock(&q.lock);
+			q.written++;
+			pthread_cond_broadcast(&q.changed);
+			pthread_mutex_unlock(&q.lock);
+		}
+		for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+	}
+	pthread_cond_destroy(&q.changed);
+	pthread_mutex_destroy(&q.lock);
+
+cleanup:
+	for (int i = 0; i < files; i++) {
+		if (maps[i].data) munmap(maps[i].data, maps[i].size);
+	}
+	if (q.slots) {
+		for (int k = 0; k < q.window; k++) out_free(&q.slots[k]);
+	}
+	free(q.slots);
+	free(q.chunks);
+	free(tids);
+	free(maps);
+	return checked;
+}
+
 /**
  * This function coordinates the checking of palindrom input sequences across the multiple input files.
+ * Regular files are mapped into memory and their results are written in large
+ * blocks, other inputs (e.g. stdin or pipes) are read line by line. With
+ * multiple threads, consecutive regular files are checked in parallel.
  *
  * @param infiles this is an array of read-accessable files
  * @param in_len the number of input files
  * @param outfile this is an write-accessable file
- * @param ignore_case flag, indicating if casing should be ignored
- * @param ignore_whitespaces flag, indicating if whitespaces should be ignored
+ * @param opts how the lines are checked
+ * @param threads number of threads checking regular files
  */
-void check_palindrom(FILE **infiles, int in_len, FILE *outfile, int ignore_case, int ignore_whitespaces) {
+void check_palindrom(FILE **infiles, int in_len, FILE *outfile, const check_options *opts, int threads) {
 	char* str = NULL;
 	size_t len = 0;
+	ssize_t n;
+	out_buffer o;
+	if (out_init(&o, fileno(outfile), OUT_BUF_SIZE) < 0) {
+		fprintf(stderr, "Out of memory!\n");
+		exit(1);
+	}
+
 	for (int i = 0; i<in_len; i++) {
-		while (getline(&str, &len, infiles[i]) != -1) {
-			str[strcspn(str, "\n")] = 0; // remove any trailing carrage characters
-			fprintf(outfile, "%s ", str);
-			if (is_palindrom(str, ignore_case, ignore_whitespaces)) {
-				fprintf(outfile, "is a palindrom\n");
-			} else {
-				fprintf(outfile, "is not a palindrom\n");
-			}
-			if (infiles[i]==stdin) fflush(outfile); // flush in case program gets terminated (<Ctrl+C> instead of <Ctrl+D>)
+		if (threads > 1 && (n = check_parallel(infiles + i, in_len - i, &o, opts, threads)) > 0) {
+			i += n - 1;
+			continue;
+		}
+		if (check_mapped(infiles[i], &o, opts) == 0) continue;
+
+		while ((n = getline(&str, &len, infiles[i])) != -1) {
+			if (n > 0 && str[n-1] == '\n') n--; // ignore the trailing newline, the line itself is left untouched
+			check_line(str, n, &o, opts);
+			/* write before the next line overwrites str, if the output refers to it, and
+			 * flush in case program gets terminated (<Ctrl+C> instead of <Ctrl+D>) */
+			if (n >= OUT_REF_MIN || infiles[i]==stdin) out_write(&o, o.fd);
 		}
 	}
-	fflush(outfile);
+	out_write(&o, o.fd);
+	out_free(&o);
 	//if (str) free(str);
 }
 
+/**
+ * Folds an ASCII character to lower case, like tolower in the "C" locale
+ */
+static inline char fold_case(char ch) {
+	return (ch >= 'A' && ch <= 'Z') ? ch + ('a' - 'A') : ch;
+}
+
+/**
+ * Compares the characters of str[*i..*j) from both ends, skipping whitespaces
+ * and folding the case on the fly, until the ends meet or max steps are done.
+ *
+ * @param str the input
+ * @param i index of the first character not yet compared, advanced by the comparison
+ * @param j index after the last character not yet compared, reduced by the comparison
+ * @param ignore_case if set, upper case is ignored
+ * @param ignore_whitespaces if set, all whitespaces are ignored
+ * @param steps max. number of characters to consume
+ * @return 0 if a mismatch was found, else 1
+ */
+static int compare_scalar(const char *str, size_t *i, size_t *j, int ignore_case, int ignore_whitespaces, size_t steps) {
+	size_t l = *i, r = *j;
+	while (l + 1 < r && steps--) {
+		char a = str[l], b = str[r-1];
+		if (ignore_whitespaces && a == ' ') { l++; continue; }
+		if (ignore_whitespaces && b == ' ') { r--; continue; }
+		if (ignore_case) { a = fold_case(a); b = fold_case(b); }
+		if (a != b) return 0;
+		l++; r--;
+	}
+	*i = l;
+	*j = r;
+	return 1;
+}
+
+/**
+ * Folds a code point to lower case with the simple case folding of Unicode
+ * for the Latin, Greek, Cyrillic and Armenian scripts and fullwidth Latin.
+ * Other code points are left untouched.
+ */
+static uint32_t fold_codepoint(uint32_t c) {
+	if (c < 0x80) return (c >= 'A' && c <= 'Z') ? c + 32 : c;
+	if (c < 0x100) {
+		if (c == 0xB5) return 0x3BC; // micro sign to mu
+		return (c >= 0xC0 && c <= 0xDE && c != 0xD7) ? c + 32 : c;
+	}
+	if (c < 0x180) { // Latin Extended-A, pairs of upper and lower case
+		if (c == 0x178) return 0xFF;
+		if (c == 0x17F) return 's';
+		if (c <= 0x12F || (c >= 0x132 && c <= 0x137) || (c >= 0x14A && c <= 0x177)) return c | 1;
+		if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E)) return (c & 1) ? c + 1 : c;
+		return c;
+	}
+	if (c >= 0x370 && c < 0x400) { // Greek
+		if (c >= 0x391 && c <= 0x3AB && c != 0x3A2) return c + 32;
+		if (c == 0x386) return 0x3AC;
+		if (c >= 0x388 && c <= 0x38A) return c + 37;
+		if (c == 0x38C) return 0x3CC;
+		if (c == 0x38E || c == 0x38F) return c + 63;
+		if (c == 0x3C2) return 0x3C3; // final sigma
+		return c;
+	}
+	if (c >= 0x400 && c < 0x530) { // Cyrillic
+		if (c < 0x410) return c + 80;
+		if (c < 0x430) return c + 32;
+		if ((c >= 0x460 && c <= 0x481) || (c >= 0x48A && c <= 0x4BF) || c >= 0x4D0) return c | 1;
+		if (c == 0x4C0) return 0x4CF;
+		if (c >= 0x4C1 && c <= 0x4CE) return (c & 1) ? c + 1 : c;
+		return c;
+	}
+	if (c >= 0x531 && c <= 0x556) return c + 48; // Armenian
+	if ((c >= 0x1E00 && c <= 0x1E95) || (c >= 0x1EA0 && c <= 0x1EFF)) return c | 1; // Latin Extended Additional
+	if (c == 0x1E9E) return 0xDF; // capital sharp s
+	if (c >= 0xFF21 && c <= 0xFF3A) return c + 32;
+	return c;
+}
+
+/**
+ * Checks whether a code point has the White_Space property of Unicode
+ */
+static int is_space_codepoint(uint32_t c) {
+	return c == ' ' || (c >= '\t' && c <= '\r') || c == 0x85 || c == 0xA0 || c == 0x1680 ||
+		(c >= 0x2000 && c <= 0x200A) || c == 0x2028 || c == 0x2029 || c == 0x202F || c == 0x205F || c == 0x3000;
+}
+
+/**
+ * Decodes the UTF-8 sequence starting at s[i]. A byte, which doesn't start a
+ * valid sequence (overlong, surrogate, truncated, ...), is decoded on its own.
+ *
+ * @param s the input
+ * @param i index of the first byte of the sequence
+ * @param end index after the last byte, which may be part of the sequence
+ * @param cp the decoded code point, INVALID_BYTE + byte for an invalid byte
+ * @return the length of the sequence
+ */
+static size_t decode_utf8(const unsigned char *s, size_t i, size_t end, uint32_t *cp) {
+	unsigned char c = s[i];
+	size_t n = 0;
+	uint32_t v = 0, min = 0;
+	if (c < 0x80) {
+		*cp = c;
+		return 1;
+	}
+	if (c >= 0xC2 && c <= 0xDF) { n = 2; v = c & 0x1F; min = 0x80; }
+	else if (c >= 0xE0 && c <= 0xEF) { n = 3; v = c & 0x0F; min = 0x800; }
+	else if (c >= 0xF0 && c <= 0xF4) { n = 4; v = c & 0x07; min = 0x10000; }
+
+	if (n > 0 && end - i >= n) {
+		size_t k = 1;
+		for (; k < n && (s[i+k] & 0xC0) == 0x80; k++) v = (v << 6) | (s[i+k] & 0x3F);
+		if (k == n && v >= min && v <= 0x10FFFF && (v < 0xD800 || v > 0xDFFF)) {
+			*cp = v;
+			return n;
+		}
+	}
+	*cp = INVALID_BYTE + c;
+	return 1;
+}
+
+/**
+ * Decodes the UTF-8 sequence ending before s[end], splitting invalid bytes
+ * the same way as decode_utf8 does from the front.
+ *
+ * @param s the input
+ * @param begin index of the first byte, which may be part of the sequence
+ * @param end index after the last byte of the sequence
+ * @param cp the decoded code point
+ * @return the length of the sequence
+ */
+static size_t decode_utf8_back(const unsigned char *s, size_t begin, size_t end, uint32_t *cp) {
+	size_t k = 1;
+	while (k < 4 && end - k > begin && (s[end-k] & 0xC0) == 0x80) k++;
+	if (decode_utf8(s, end - k, end, cp) == k) return k;
+	*cp = INVALID_BYTE + s[end-1];
+	return 1;
+}
+
+/**
+ * Compares the UTF-8 characters of str[*i..*j) from both ends like
+ * compare_scalar. ASCII bytes are compared directly, other characters are
+ * decoded, folded to lower case and skipped if they are whitespaces.
+ *
+ * @param str the input
+ * @param i index of the first byte not yet compared, advanced by the comparison
+ * @param j index after the last byte not yet compared, reduced by the comparison
+ * @param ignore_case if set, upper case is ignored
+ * @param ignore_whitespaces if set, all whitespaces are ignored
+ * @param steps max. number of characters to consume
+ * @return 0 if a mismatch was found, else 1
+ */
+static int compare_utf8(const char *str, size_t *i, size_t *j, int ignore_case, int ignore_whitespaces, size_t steps) {
+	const unsigned char *s = (const unsigned char*)str;
+	size_t l = *i, r = *j;
+	while (l + 1 < r && steps--) {
+		uint32_t a = s[l], b = s[r-1];
+		size_t la = 1, lb = 1;
+		if (a >= 0x80) la = decode_utf8(s, l, r, &a);
+		if (b >= 0x80) lb = decode_utf8_back(s, l, r, &b);
+		if (l + la > r - lb) break; // both ends reached the character in the middle
+		if (ignore_whitespaces && is_space_codepoint(a)) { l += la; continue; }
+		if (ignore_whitespaces && is_space_codepoint(b)) { r -= lb; continue; }
+		if (ignore_case) { a = fold_codepoint(a); b = fold_codepoint(b); }
+		if (a != b) return 0;
+		l += la;
+		r -= lb;
+	}
+	*i = l;
+	*j = r;
+	return 1;
+}
+
+/**
+ * Scalar kernel: one pass with two pointers
+ */
+static int palindrom_scalar(const char *str, size_t len, int ignore_case, int ignore_whitespaces, int utf8) {
+	size_t i = 0, j = len;
+	if (utf8) return compare_utf8(str, &i, &j, ignore_case, ignore_whitespaces, (size_t)-1);
+	return compare_scalar(str, &i, &j, ignore_case, ignore_whitespaces, (size_t)-1);
+}
+
+#ifdef HAVE_X86_SIMD
+/**
+ * SSE2 kernel: compares 16 byte blocks from both ends. The block from the end
+ * is reversed with shuffles, upper case letters are folded with a range
+ * compare. Blocks containing whitespaces (if they are ignored) are handled by
+ * the scalar comparison, which realigns both ends. In UTF-8 mode, blocks with
+ * non-ASCII bytes (or any control character, if whitespaces are ignored) are
+ * compared character by character, so ASCII text stays on the fast path.
+ */
+__attribute__((target("sse2")))
+static int palindrom_sse2(const char *str, size_t len, int ignore_case, int ignore_whitespaces, int utf8) {
+	const __m128i space = _mm_set1_epi8(' '), before_a = _mm_set1_epi8('A' - 1),
+		after_z = _mm_set1_epi8('Z' + 1), bit = _mm_set1_epi8(0x20), after_space = _mm_set1_epi8(' ' + 1);
+	size_t i = 0, j = len;
+
+	while (j - i >= 32) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(str + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(str + j - 16));
+		if (utf8) {
+			/* signed compare: non-ASCII bytes are negative */
+			__m128i special = ignore_whitespaces ? _mm_or_si128(_mm_cmpgt_epi8(after_space, a), _mm_cmpgt_epi8(after_space, b)) : _mm_or_si128(a, b);
+			if (_mm_movemask_epi8(special)) {
+				if (!compare_utf8(str, &i, &j, ignore_case, ignore_whitespaces, 16)) return 0;
+				continue;
+			}
+		} else if (ignore_whitespaces && _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(a, space), _mm_cmpeq_epi8(b, space)))) {
+			if (!compare_scalar(str, &i, &j, ignore_case, ignore_whitespaces, 16)) return 0;
+			continue;
+		}
+		if (ignore_case) {
+			a = _mm_or_si128(a, _mm_and_si128(bit, _mm_and_si128(_mm_cmpgt_epi8(a, before_a), _mm_cmpgt_epi8(after_z, a))));
+			b = _mm_or_si128(b, _mm_and_si128(bit, _mm_and_si128(_mm_cmpgt_epi8(b, before_a), _mm_cmpgt_epi8(after_z, b))));
+		}
+		/* reverse the bytes: dwords, then words, then the bytes of the words */
+		b = _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 1, 2, 3));
+		b = _mm_shufflelo_epi16(b, _MM_SHUFFLE(2, 3, 0, 1));
+		b = _mm_shufflehi_epi16(b, _MM_SHUFFLE(2, 3, 0, 1));
+		b = _mm_or_si128(_mm_slli_epi16(b, 8), _mm_srli_epi16(b, 8));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF) return 0;
+		i += 16;
+		j -= 16;
+	}
+	if (utf8) return compare_utf8(str, &i, &j, ignore_case, ignore_whitespaces, (size_t)-1);
+	return compare_scalar(str, &i, &j, ignore_case, ignore_whitespaces, (size_t)-1);
+}
+
+/**
+ * AVX2 kernel: like the SSE2 kernel with 32 byte blocks, the block is
+ * reversed with a byte shuffle within the lanes and a swap of the lanes.
+ */
+__attribute__((target("avx2")))
+static int palindrom_avx2(const char *str, size_t len, int ignore_case, int ignore_whitespaces, int utf8) {
+	const __m256i space = _mm256_set1_epi8(' '), before_a = _mm256_set1_epi8('A' - 1),
+		after_z = _mm256_set1_epi8('Z' + 1), bit = _mm256_set1_epi8(0x20), after_space = _mm256_set1_epi8(' ' + 1),
+		reverse = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+			15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+	size_t i = 0, j = len;
+
+	while (j - i >= 64) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)(str + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(str + j - 32));
+		if (utf8) {
+			__m256i special = ignore_whitespaces ? _mm256_or_si256(_mm256_cmpgt_epi8(after_space, a), _mm256_cmpgt_epi8(after_space, b)) : _mm256_or_si256(a, b);
+			if (_mm256_movemask_epi8(special)) {
+				if (!compare_utf8(str, &i, &j, ignore_case, ignore_whitespaces, 32)) return 0;
+				continue;
+			}
+		} else if (ignore_whitespaces && _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(a, space), _mm256_cmpeq_epi8(b, space)))) {
+			if (!compare_scalar(str, &i, &j, ignore_case, ignore_whitespaces, 32)) return 0;
+			continue;
+		}
+		if (ignore_case) {
+			a = _mm256_or_si256(a, _mm256_and_si256(bit, _mm256_and_si256(_mm256_cmpgt_epi8(a, before_a), _mm256_cmpgt_epi8(after_z, a))));
+			b = _mm256_or_si256(b, _mm256_and_si256(bit, _mm256_and_si256(_mm256_cmpgt_epi8(b, before_a), _mm256_cmpgt_epi8(after_z, b))));
+		}
+		b = _mm256_permute2x128_si256(_mm256_shuffle_epi8(b, reverse), b, 0x01);
+		if ((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) != 0xFFFFFFFFu) return 0;
+		i += 32;
+		j -= 32;
+	}
+	return palindrom_sse2(str + i, j - i, ignore_case, ignore_whitespaces, utf8);
+}
+#endif
+
+/**
+ * Selects the fastest kernel supported by the CPU, once
+ */
+static palindrom_kernel select_kernel(void) {
+	static palindrom_kernel kernel = NULL;
+	if (kernel) return kernel;
+	kernel = palindrom_scalar;
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) kernel = palindrom_avx2;
+	else if (__builtin_cpu_supports("sse2")) kernel = palindrom_sse2;
+#endif
+	return kernel;
+}
+
+/**
+ * Appends a part of the input to the output, long parts are referenced instead of copied
+ */
+static void out_input(out_buffer *o, const char *data, size_t len) {
+	if (len >= OUT_REF_MIN) out_ref(o, data, len);
+	else out_copy(o, data, len);
+}
+
+/**
+ * Appends a number in decimal to the output
+ */
+static void out_number(out_buffer *o, size_t n) {
+	char num[24];
+	out_copy(o, num, snprintf(num, sizeof(num), "%zu", n));
+}
+
+/**
+ * Returns the index after the character starting at s[i]
+ */
+static size_t char_end(const unsigned char *s, size_t i, size_t len, int utf8) {
+	uint32_t c;
+	return i + (utf8 ? decode_utf8(s, i, len, &c) : 1);
+}
+
+/**
+ * Computes the radii of the longest palindroms around every center of a
+ * normalized line with Manacher's algorithm in linear time. Palindroms found
+ * earlier are mirrored to skip the comparisons they already proved.
+ *
+ * @param u the normalized characters
+ * @param n number of characters in u
+ * @param odd odd[k] is set to the radius of the longest palindrom centered at k, u[k-odd[k]+1..k+odd[k])
+ * @param even even[k] is set to the radius of the longest palindrom centered before k, u[k-even[k]..k+even[k])
+ */
+static void manacher(const uint32_t *u, size_t n, uint32_t *odd, uint32_t *even) {
+	/* [l, r) is the palindrom reaching furthest to the right */
+	for (size_t k = 0, l = 0, r = 0; k < n; k++) {
+		size_t d = k >= r ? 1 : (odd[l + r - 1 - k] < r - k ? odd[l + r - 1 - k] : r - k);
+		while (d <= k && k + d < n && u[k-d] == u[k+d]) d++;
+		odd[k] = d;
+		if (k + d > r) {
+			l = k - d + 1;
+			r = k + d;
+		}
+	}
+	for (size_t k = 0, l = 0, r = 0; k < n; k++) {
+		size_t d = k >= r ? 0 : (even[l + r - k] < r - k ? even[l + r - k] : r - k);
+		while (d < k && k + d < n && u[k-d-1] == u[k+d]) d++;
+		even[k] = d;
+		if (k + d > r) {
+			l = k - d;
+			r = k + d;
+		}
+	}
+}
+
+/**
+ * Searches a line for palindromic substrings and collects the result in the
+ * output, either the longest one or all maximal ones (which can't be extended
+ * around their center) with at least min_length characters. The line is
+ * normalized like is_palindrom compares it, the positions of the normalized
+ * characters map the palindroms back to the bytes of the line, so whitespaces
+ * inside of a palindrom are part of it.
+ *
+ * @param str the line without the newline
+ * @param len number of bytes in str
+ * @param o the output buffer
+ * @param opts how the line is normalized and which palindroms are reported
+ */
+static void search_line(const char *str, size_t len, out_buffer *o, const check_options *opts) {
+	if (len > UINT32_MAX) {
+		fprintf(stderr, "Lines longer than %u bytes can't be searched!\n", UINT32_MAX);
+		return;
+	}
+	uint32_t *u = malloc(4 * (len + 1) * sizeof(uint32_t));
+	if (u == NULL) {
+		fprintf(stderr, "Out of memory!\n");
+		exit(1);
+	}
+	uint32_t *pos = u + len + 1, *odd = pos + len + 1, *even = odd + len + 1; // byte offsets of the normalized characters and radii
+
+	/* normalize the line */
+	const unsigned char *s = (const unsigned char*)str;
+	size_t n = 0;
+	for (size_t i = 0, l; i < len; i += l) {
+		uint32_t c = s[i];
+		l = 1;
+		if (opts->utf8 && c >= 0x80) l = decode_utf8(s, i, len, &c);
+		if (opts->ignore_whitespaces && (opts->utf8 ? is_space_codepoint(c) : c == ' ')) continue;
+		if (opts->ignore_case) c = opts->utf8 ? fold_codepoint(c) : (unsigned char)fold_case(c);
+		u[n] = c;
+		pos[n++] = i;
+	}
+	manacher(u, n, odd, even);
+
+	out_input(o, str, len);
+	if (opts->longest) {
+		size_t best = 0, first = 0;
+		for (size_t k = 0; k < n; k++) {
+			if (2 * (size_t)even[k] > best) { best = 2 * (size_t)even[k]; first = k - even[k]; }
+			if (2 * (size_t)odd[k] - 1 > best) { best = 2 * (size_t)odd[k] - 1; first = k - odd[k] + 1; }
+		}
+		size_t start = best ? pos[first] : 0, end = best ? char_end(s, pos[first + best - 1], len, opts->utf8) : 0;
+		out_copy(o, " has the longest palindrom '", 28);
+		out_input(o, str + start, end - start);
+		out_copy(o, "' at ", 5);
+		out_number(o, start);
+		out_copy(o, "\n", 1);
+	} else {
+		int found = 0;
+		for (size_t k = 0; k < n; k++) {
+			/* centers in order: before u[k], then at u[k] */
+			for (int at = 0; at < 2; at++) {
+				size_t length = at ? 2 * (size_t)odd[k] - 1 : 2 * (size_t)even[k];
+				if (length < opts->min_length || length == 0) continue;
+				size_t first = at ? k - odd[k] + 1 : k - even[k];
+				size_t start = pos[first], end = char_end(s, pos[first + length - 1], len, opts->utf8);
+				if (found++) out_copy(o, " ", 1);
+				else out_copy(o, " contains palindroms at ", 24);
+				out_number(o, start);
+				out_copy(o, ":", 1);
+				out_number(o, end - start);
+			}
+		}
+		if (found) out_copy(o, "\n", 1);
+		else out_copy(o, " contains no palindroms\n", 24);
+	}
+	free(u);
+}
+
 /**
  * This function checks whether a given string is a palindrom,
  * meaning, that it is read the same forward and backwards
+ * The string is compared from both ends in a single pass, whitespaces are
+ * skipped and the case is folded on the fly. Long strings are compared in
+ * blocks of 16 or 32 bytes with SSE2 or AVX2, if the CPU supports it.
+ * In UTF-8 mode, characters are compared instead of bytes, but ASCII parts
+ * are still compared in blocks.
  *
- * @param str the input to be validated, it could be manipulated in the process
+ * @param str the input to be validated, it is not modified and doesn't need to be terminated
+ * @param len the number of characters in str (e.g. the return value of getline without the newline)
  * @param ignore_case if set to 0, upper case is ignored
  * @param ignore_whitespace if set to 0, all whitespaces are ignored
+ * @param utf8 if set, the UTF-8 characters are compared (with Unicode case folding and whitespaces)
  * @return 1 if it is a palindrom, else it is not
  */
-int is_palindrom(char *str, int ignore_case, int ignore_whitespaces) {
-	if (ignore_whitespaces) {
-		int j = 0;
-		for (int i=0;str[i]; i++) {
-			if (str[i] != ' ') str[j++] = str[i];
-		}
-		str[j] = 0;
-	}
-	if (ignore_case) for (int i =0; str[i]; i++) str[i] = tolower(str[i]);
-
-	int i = 0, j = strlen(str) - 1;
-	while (j > i) if (str[i++] != str[j--]) return(EXIT_SUCCESS);
-
-	return(EXIT_FAILURE);
+int is_palindrom(const char *str, size_t len, int ignore_case, int ignore_whitespaces, int utf8) {
+	if (select_kernel()(str, len, ignore_case, ignore_whitespaces, utf8)) return(EXIT_FAILURE);
+	return(EXIT_SUCCESS);
 }
 
 /**
@@ -84,10 +885,10 @@ int is_palindrom(char *str, int ignore_case, int ignore_whitespaces) {
 int main(int argc, char *argv[])
 {
 	/* Argument Parsing */
-	char *o_arg = NULL;
-	int opt_s = 0, opt_i = 0, opt_o = 0;
+	char *o_arg = NULL, *j_arg = NULL, *m_arg = NULL;
+	int opt_s = 0, opt_i = 0, opt_u = 0, opt_l = 0, opt_m = 0, opt_o = 0, opt_j = 0;
 	int c;
-	while((c=getopt(argc, argv, "sio:")) != -1) {
+	while((c=getopt(argc, argv, "siulm:j:o:")) != -1) {
 		switch (c){
 			case 's':// option to ignore whitespaces
 				opt_s++;
@@ -95,6 +896,20 @@ int main(int argc, char *argv[])
 			case 'i':// option to ignore case
 				opt_i++;
 				break;
+			case 'u':// option to compare UTF-8 characters
+				opt_u++;
+				break;
+			case 'l':// option to search the longest palindrom of each line
+				opt_l++;
+				break;
+			case 'm':// option to search all maximal palindroms of a min. length
+				opt_m++;
+				m_arg = optarg;
+				break;
+			case 'j':// option to set the number of threads
+				opt_j++;
+				j_arg = optarg;
+				break;
 			case 'o':// option to set outfile
 				opt_o++;
 				o_arg = optarg;
@@ -106,10 +921,36 @@ int main(int argc, char *argv[])
 				break;
 		}
 	}
-	if (opt_s > 1 || opt_i > 1 || opt_o > 1) {
+	if (opt_s > 1 || opt_i > 1 || opt_u > 1 || opt_l > 1 || opt_m > 1 || opt_o > 1 || opt_j > 1) {
 		fprintf(stderr, "Every option can only be used unce!\n");
 		usage(argv[0]);
 	} // option is repeated
+	if (opt_l && opt_m) {
+		fprintf(stderr, "Only one of -l and -m can be used!\n");
+		usage(argv[0]);
+	}
+
+	check_options opts = { .ignore_case = opt_i, .ignore_whitespaces = opt_s, .utf8 = opt_u, .longest = opt_l, .min_length = 0 };
+	if (m_arg != NULL) {
+		char *end;
+		long n = strtol(m_arg, &end, 10);
+		if (*end != '\0' || n < 1) {
+			fprintf(stderr, "The min. length of the palindroms has to be at least 1!\n");
+			usage(argv[0]);
+		}
+		opts.min_length = n;
+	}
+
+	int threads = 1;
+	if (j_arg != NULL) {
+		char *end;
+		long n = strtol(j_arg, &end, 10);
+		if (*end != '\0' || n < 1 || n > MAX_THREADS) {
+			fprintf(stderr, "The number of threads has to be between 1 and %i!\n", MAX_THREADS);
+			usage(argv[0]);
+		}
+		threads = n;
+	}
 
 	/* create i/o streams */
 	FILE *outfile_fp, **infile_fp;
@@ -132,7 +973,7 @@ int main(int argc, char *argv[])
 		infiles = 1;
 	}
 
-	check_palindrom(infile_fp, infiles, outfile_fp, opt_i, opt_s);
+	check_palindrom(infile_fp, infiles, outfile_fp, &opts, threads);
 	for (int i = 0; i<infiles; i++) {
 		fclose(infile_fp[i]);
 	}
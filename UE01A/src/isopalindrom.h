@@ -3,8 +3,17 @@
 
 // static void usage(void);
 
-void check_palindrom(FILE **infiles, int in_len, FILE *outfile, int ignore_case, int ignore_whitespaces);
-int is_palindrom(char *str, int ignore_case, int ignore_whitespaces); 
+/** how the lines are checked */
+typedef struct check_options {
+	int ignore_case;			/** upper case is ignored */
+	int ignore_whitespaces;		/** whitespaces are ignored */
+	int utf8;					/** UTF-8 characters are compared instead of bytes */
+	int longest;				/** the longest palindrom of every line is searched */
+	size_t min_length;			/** if > 0, all maximal palindroms with at least min_length characters are searched */
+} check_options;
+
+void check_palindrom(FILE **infiles, int in_len, FILE *outfile, const check_options *opts, int threads);
+int is_palindrom(const char *str, size_t len, int ignore_case, int ignore_whitespaces, int utf8);
 
 int main(int argc, char *argv[]);
 
@@ -0,0 +1,158 @@
+/**
+ * @file accesslog.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Asynchronous, batched access log
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "accesslog.h"
+
+static int log_fd = -1;             /** the log file, -1 if the log is disabled */
+static pthread_t writer;            /** thread writing the batches */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wakeup = PTHREAD_COND_INITIALIZER;
+static log_batch* head = NULL;      /** first batch waiting to be written */
+static log_batch* tail = NULL;      /** last batch waiting to be written */
+static int pending = 0;             /** number of batches waiting */
+static int stopping = 0;            /** the writer exits, once all batches are written */
+static unsigned long dropped = 0;   /** batches dropped, because the writer fell behind */
+
+/** @brief writes a batch completely, errors are ignored */
+static void write_batch(log_batch* b) {
+    for (size_t off = 0; off < b->len;) {
+        ssize_t n = write(log_fd, b->data + off, b->len - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        off += n;
+    }
+}
+
+/**
+ * @brief Main loop of the writer thread
+ * @details Takes all waiting batches at once and writes them outside of the lock.
+ *
+ * @param arg unused
+ * @return always NULL
+ */
+static void* writer_loop(void* arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&lock);
+        while (head == NULL && !stopping) pthread_cond_wait(&wakeup, &lock);
+        log_batch* b = head;
+        head = tail = NULL;
+        pending = 0;
+        pthread_mutex_unlock(&lock);
+
+        if (b == NULL) return NULL; // stopping and nothing left to write
+        while (b) {
+            log_batch* next = b->next;
+            write_batch(b);
+            free(b);
+            b = next;
+        }
+    }
+}
+
+int accesslog_open(const char* path) {
+    int fd = STDOUT_FILENO;
+    if (path && (fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)) < 0) return -1;
+
+    log_fd = fd;
+    stopping = 0;
+    if ((errno = pthread_create(&writer, NULL, writer_loop, NULL)) != 0) {
+        if (path) close(fd);
+        log_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+unsigned long accesslog_close(void) {
+    if (log_fd < 0) return 0;
+
+    pthread_mutex_lock(&lock);
+    stopping = 1;
+    pthread_cond_signal(&wakeup);
+    pthread_mutex_unlock(&lock);
+    pthread_join(writer, NULL);
+
+    if (log_fd != STDOUT_FILENO) close(log_fd);
+    log_fd = -1;
+    return dropped;
+}
+
+int accesslog_enabled(void) {
+    return log_fd >= 0;
+}
+
+const char* accesslog_date(access_log* l) {
+    time_t now = time(NULL);
+    if (now != l->date_time) {
+        struct tm tm;
+        strftime(l->date, sizeof(l->date), "%d/%b/%Y:%H:%M:%S +0000", gmtime_r(&now, &tm));
+        l->date_time = now;
+    }
+    return l->date;
+}
+
+void accesslog_printf(access_log* l, const char* fmt, ...) {
+    if (log_fd < 0) return;
+
+    for (int tries = 0; tries < 2; tries++) {
+        if (l->batch == NULL) {
+            if ((l->batch = malloc(sizeof(log_batch))) == NULL) return; // the line is lost
+            l->batch->len = 0;
+            l->batch->next = NULL;
+        }
+
+        log_batch* b = l->batch;
+        size_t space = LOG_BATCH_SIZE - b->len;
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(b->data + b->len, space, fmt, ap);
+        va_end(ap);
+        if (n < 0) return;
+
+        if ((size_t)n < space) {
+            b->len += n;
+            return;
+        }
+        if (b->len == 0) {
+            /* a single line longer than a batch is cut off */
+            b->len = LOG_BATCH_SIZE;
+            b->data[LOG_BATCH_SIZE - 1] = '\n';
+            return;
+        }
+        accesslog_flush(l); // retry in an empty batch
+    }
+}
+
+void accesslog_flush(access_log* l) {
+    log_batch* b = l->batch;
+    if (b == NULL || b->len == 0) return;
+
+    pthread_mutex_lock(&lock);
+    if (pending >= LOG_MAX_PENDING) {
+        dropped++;
+        pthread_mutex_unlock(&lock);
+        b->len = 0; // reuse the batch
+        return;
+    }
+    if (tail) tail->next = b;
+    else head = b;
+    tail = b;
+    pending++;
+    pthread_cond_signal(&wakeup);
+    pthread_mutex_unlock(&lock);
+    l->batch = NULL;
+}
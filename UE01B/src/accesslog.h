@@ -0,0 +1,81 @@
+/**
+ * @file accesslog.h
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Asynchronous, batched access log
+ * @details The workers format their log lines into a batch of their own,
+ * without any locking or system calls. Full batches (and the current batch
+ * once per second) are handed to a writer thread, which writes them with a
+ * single write each. If the writer falls behind by more than LOG_MAX_PENDING
+ * batches, further batches are dropped instead of slowing down the workers.
+ */
+#ifndef ACCESSLOG_H_   /* Include guard */
+#define ACCESSLOG_H_
+
+#include <stddef.h>
+#include <time.h>
+
+#define LOG_BATCH_SIZE (64 << 10)   // bytes of log lines written with a single write
+#define LOG_MAX_PENDING 64          // batches waiting for the writer before new ones are dropped
+
+/** @brief log lines waiting to be written */
+typedef struct log_batch {
+    size_t len;                 /** number of bytes in data */
+    struct log_batch* next;     /** next batch in the queue of the writer */
+    char data[LOG_BATCH_SIZE];  /** the log lines */
+} log_batch;
+
+/** @brief the log state of a worker */
+typedef struct access_log {
+    log_batch* batch;           /** batch currently filled, NULL if there is none */
+    time_t date_time;           /** time date has been generated for */
+    char date[32];              /** timestamp of the current second in common log format */
+} access_log;
+
+/**
+ * @brief Opens the log file and starts the writer thread
+ *
+ * @param path the log file (appended to), NULL to log to stdout
+ * @return 0 on success, -1 on failure (errno is set)
+ */
+int accesslog_open(const char* path);
+
+/**
+ * @brief Writes all handed over batches, stops the writer and closes the log file
+ * @details The workers have to be stopped and their logs flushed before.
+ *
+ * @return the number of batches which had to be dropped
+ */
+unsigned long accesslog_close(void);
+
+/**
+ * @brief Tells whether the access log has been opened
+ */
+int accesslog_enabled(void);
+
+/**
+ * @brief Returns the timestamp of the current second as used in the log
+ *
+ * @param l the log of the calling worker
+ * @return the timestamp, e.g. "17/Oct/2026:12:00:00 +0000"
+ */
+const char* accesslog_date(access_log* l);
+
+/**
+ * @brief Appends a line to the current batch of a worker
+ * @details Does nothing, if the log is disabled.
+ *
+ * @param l the log of the calling worker
+ * @param fmt printf style format of the line, including the "\n"
+ */
+void accesslog_printf(access_log* l, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Hands the current batch of a worker over to the writer
+ *
+ * @param l the log of the calling worker
+ */
+void accesslog_flush(access_log* l);
+
+#endif // ACCESSLOG_H_
@@ -14,12 +14,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/types.h>
+#include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
 //#include <ctype.h>
 #include "client.h"
+#include "fetch.h"
+#include "loadgen.h"
 static void usage(char* pname);
 
 static char* pname;
@@ -28,20 +32,58 @@ static char* pname;
  * @brief Prints the correct usage of the Programm
  */
 static void usage(char* pname_) {
-	fprintf(stderr, "%s: Usage: %s [-p PORT] [-o FILE | -d DIR] URL\n\t-p PORT to connect to (default = 80)\n\t-o write output to specified file\n\t-d directory to write response to\n", pname, pname_);
+	fprintf(stderr, "%s: Usage: %s [-p PORT] [-o FILE | -n REQUESTS [-c CONCURRENCY] [-k]] URL\n"
+		"       %s [-p PORT] -d DIR [-c CONCURRENCY] [-l LIST] [URL...]\n"
+		"\t-p PORT to connect to (default = 80)\n"
+		"\t-o write output to specified file\n"
+		"\t-d directory to download the URLs to\n"
+		"\t-l read URLs from a file, one per line (- for stdin)\n"
+		"\t-n benchmark the server with the specified number of requests\n"
+		"\t-c number of concurrent connections (default = 1 for -n, %i for -d)\n"
+		"\t-k reuse connections for multiple requests (keep-alive)\n", pname, pname_, pname_, FETCH_CONCURRENCY);
 	exit(EXIT_FAILURE);
 }
 
-int request(char* url, char* port, FILE* outfile){
-
+/**
+ * @brief extracts the hostname and the requested file from an URL
+ *
+ * @param url the URL to analyze
+ * @param host is set to the hostname (has to be freed)
+ * @param file is set to the requested file, "/" if the URL contains none (has to be freed)
+ */
+void split_url(char* url, char** host, char** file) {
 	int *p = urlinfo(url);
-	//printf("%i, %i, %i\n", p[0], p[1], p[2]);
-	char* hostname = malloc(strlen(url)+1);
-	strncpy(hostname, url+p[0], p[1]-p[0]);
-	// printf("%s\n", hostname);
-	char* file = malloc(strlen(url)+10);
-	strncpy(file, url+p[2], strlen(url)+1-p[2]);
-	// printf("%s %s\n", hostname, file);
+	*host = calloc(p[1]-p[0]+1, sizeof(char));
+	strncpy(*host, url+p[0], p[1]-p[0]);
+	*file = strdup(url[p[2]] ? url+p[2] : "/");
+}
+
+/**
+ * @brief reads a list of URLs, one per line, empty lines and lines starting with '#' are skipped
+ *
+ * @param list the file to read from
+ * @param urls the array the URLs are appended to, resized as needed
+ * @param count number of entries in urls, updated
+ */
+static void read_urls(FILE* list, char*** urls, int* count) {
+	char* line = NULL;
+	size_t len = 0;
+	ssize_t n;
+	while ((n = getline(&line, &len, list)) > 0) {
+		while (n > 0 && (line[n-1] == '\n' || line[n-1] == '\r' || line[n-1] == ' ' || line[n-1] == '\t'))
+			line[--n] = '\0';
+		char* url = line + strspn(line, " \t");
+		if (*url == '\0' || *url == '#') continue;
+
+		*urls = realloc(*urls, sizeof(char*) * (*count + 1));
+		(*urls)[(*count)++] = strdup(url);
+	}
+	free(line);
+}
+
+int request(char* url, char* port, FILE* outfile){
+	char *hostname, *file;
+	split_url(url, &hostname, &file);
 
     struct addrinfo hints, *ai;
     memset(&hints, 0, sizeof hints);
@@ -67,59 +109,133 @@ int request(char* url, char* port, FILE* outfile){
         return(EXIT_FAILURE);
 	}
 
-	FILE* sockfile = fdopen(sockfd, "r+");
-	send_request(sockfile, hostname, file);
+	send_request(sockfd, hostname, file);
 
-	receive_header(sockfile);
+	char* buf = malloc(BUF_SIZE);
+	http_response resp;
+	size_t len = receive_header(sockfd, buf, &resp);
 
-	int chars_read;
-    char data[2048];
-    while ((chars_read = fread(data, 1, 2048, sockfile)) > 0)    
-		fwrite(data, 1, chars_read, outfile);
+	fflush(outfile);
+	res = receive_body(sockfd, fileno(outfile), buf, len, &resp);
+	if (res < 0) fprintf(stderr, "%s: Failed to receive the body: %s\n", pname, errno ? strerror(errno) : "Protocol error!");
 
+	free(buf);
 	freeaddrinfo(ai);
 	close(sockfd);
-	return(EXIT_SUCCESS);
+	free(hostname);
+	free(file);
+	return res < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
-void send_request(FILE* sockfile, char* host, char* file) {
+void send_request(int sockfd, char* host, char* file) {
 	int pntr = 0;
 	char* buf = calloc(1, strlen(host)+strlen(file)+100);
 	pntr = sprintf(buf, "GET %s HTTP/1.1\r\n", file);
 	pntr += sprintf(buf+pntr, "Host: %s\r\n", host);
 	pntr += sprintf(buf+pntr, "Connection: close\r\n\r\n");
-	fprintf(sockfile, "%s", buf);
-	fflush(sockfile);
+	if (http_write_all(sockfd, buf, pntr) < 0) {
+		fprintf(stderr, "%s: Failed to send the request: %s\n", pname, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
 	free(buf);
 }
 
-void receive_header(FILE* sockfile) {
-	char* buf = NULL;
+size_t receive_header(int sockfd, char* buf, http_response* resp) {
 	size_t len = 0;
-
-	if (!getline(&buf, &len, sockfile)) {
-		fprintf(stderr, "%s: Protocol error!\n", pname);
-		exit(2);
+	int res = 0;
+
+	while (res == 0 && len < BUF_SIZE) {
+		ssize_t n = read(sockfd, buf + len, BUF_SIZE - len);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break;
+		len += n;
+		res = http_parse_response(resp, buf, len);
 	}
-	char* method = strtok(buf, " ");
-    char* statuscode = strtok(NULL, " ");
-    char* statusmsg = strtok(NULL, "\r");
-
-	char* ptr;
-	strtol(statuscode, &ptr, 10);
-	if (strcmp(method, "HTTP/1.1")!=0 || strcmp(ptr, statuscode)==0) {
+	if (res != 1) {
 		fprintf(stderr, "%s: Protocol error!\n", pname);
 		exit(2);
 	}
 
-	if (atol(statuscode)!=200) {
-		fprintf(stderr, "%s: %s %s\n", pname, statuscode, statusmsg);
+	if (resp->status != 200) {
+		fprintf(stderr, "%s: %i %.*s\n", pname, resp->status, resp->reason_len, resp->reason);
 		exit(3);
 	}
 
-	while (strlen(buf)>2) {
-        getline(&buf, &len, sockfile);
-    }
+	/* move the start of the body to the front */
+	len -= resp->header_len;
+	memmove(buf, buf + resp->header_len, len);
+	return len;
+}
+
+int receive_body(int sockfd, int outfd, char* buf, size_t len, http_response* resp) {
+	errno = 0;
+	if (resp->chunked) {
+		http_chunked d;
+		http_chunked_init(&d);
+		for (;;) {
+			ssize_t n = http_decode_chunked(&d, buf, len);
+			if (n < 0 || http_write_all(outfd, buf, n) < 0) return -1;
+			if (d.done) return 0;
+			do n = read(sockfd, buf, BUF_SIZE);
+			while (n < 0 && errno == EINTR);
+			if (n <= 0) return -1;
+			len = n;
+		}
+	}
+
+	long long left = resp->content_length; // -1 if the body ends with the connection
+	if (left >= 0 && (long long)len > left) len = left;
+	if (http_write_all(outfd, buf, len) < 0) return -1;
+	if (left >= 0) left -= len;
+
+	/* splice only works, if the output is a file or a pipe, which isn't opened for appending */
+	struct stat st;
+	int pipefd[2] = {-1, -1}, flags = fcntl(outfd, F_GETFL), spliced = 0;
+	if (fstat(outfd, &st) == 0 && (S_ISREG(st.st_mode) || S_ISFIFO(st.st_mode)) && flags >= 0 &&
+		!(flags & O_APPEND) && pipe2(pipefd, O_CLOEXEC) < 0)
+		pipefd[0] = pipefd[1] = -1;
+
+	while (left != 0) {
+		size_t max = left < 0 || left > HTTP_SPLICE_MAX ? HTTP_SPLICE_MAX : left;
+		ssize_t n;
+		if (pipefd[0] >= 0) {
+			n = http_splice(sockfd, outfd, pipefd, max);
+			if (n < 0 && errno == EINVAL && !spliced) {
+				/* the output doesn't support splice, continue with read/write after
+				 * writing what is stuck in the pipe */
+				fcntl(pipefd[0], F_SETFL, O_NONBLOCK);
+				while ((n = read(pipefd[0], buf, BUF_SIZE)) > 0) {
+					if (http_write_all(outfd, buf, n) < 0) break;
+					if (left > 0) left -= n;
+				}
+				close(pipefd[0]);
+				close(pipefd[1]);
+				pipefd[0] = pipefd[1] = -1;
+				if (n > 0 || errno != EAGAIN) {
+					left = -2;
+					break;
+				}
+				continue;
+			}
+			if (n > 0) spliced = 1;
+		} else if ((n = read(sockfd, buf, max < BUF_SIZE ? max : BUF_SIZE)) > 0 && http_write_all(outfd, buf, n) < 0)
+			n = -1;
+
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) {
+			if (n == 0 && left < 0) break; // end of the body
+			if (n == 0) errno = 0;
+			left = -2;
+			break;
+		}
+		if (left > 0) left -= n;
+	}
+
+	if (pipefd[0] >= 0) {
+		close(pipefd[0]);
+		close(pipefd[1]);
+	}
+	return left == -2 ? -1 : 0;
 }
 
 /**
@@ -179,10 +295,10 @@ int* urlinfo(char* url) {
 	pname = argv[0];
 
 	/* Argument Parsing */
-	char *p_arg = NULL, *o_arg = NULL, *d_arg = NULL, *url, *port;
-	int opt_p = 0, opt_o = 0, opt_d = 0, c;
+	char *p_arg = NULL, *o_arg = NULL, *d_arg = NULL, *n_arg = NULL, *c_arg = NULL, *l_arg = NULL, *url, *port;
+	int opt_p = 0, opt_o = 0, opt_d = 0, opt_n = 0, opt_c = 0, opt_k = 0, opt_l = 0, c;
 
-	while((c=getopt(argc, argv, "p:o:d:")) != -1) {
+	while((c=getopt(argc, argv, "p:o:d:n:c:kl:")) != -1) {
  		switch (c){
  			case 'p':// option to ignore whitespaces
  				opt_p++;
@@ -196,6 +312,21 @@ int* urlinfo(char* url) {
  				opt_d++;
  				d_arg = optarg;
  				break;
+ 			case 'n':// number of requests of the benchmark
+ 				opt_n++;
+ 				n_arg = optarg;
+ 				break;
+ 			case 'c':// concurrent connections of the benchmark or the downloads
+ 				opt_c++;
+ 				c_arg = optarg;
+ 				break;
+ 			case 'k':// keep-alive for the benchmark
+ 				opt_k++;
+ 				break;
+ 			case 'l':// file with a list of URLs
+ 				opt_l++;
+ 				l_arg = optarg;
+ 				break;
 
  			case '?':
  			default:// illegal arguments
@@ -203,7 +334,7 @@ int* urlinfo(char* url) {
  				break;
  		}
  	}
- 	if (opt_p > 1 || opt_o > 1 || opt_d > 1) {
+ 	if (opt_p > 1 || opt_o > 1 || opt_d > 1 || opt_n > 1 || opt_c > 1 || opt_k > 1 || opt_l > 1) {
  		fprintf(stderr, "%s: Every option can only be used unce!\n", pname);
  		usage(argv[0]);
  	} // option is repeated
@@ -213,7 +344,27 @@ int* urlinfo(char* url) {
 		usage(argv[0]);
 	} 
 
-	if ((argc-optind)!=1) {
+	if (opt_n > 0 && (opt_o > 0 || opt_d > 0)) {
+		fprintf(stderr, "%s: The benchmark doesn't write any output!\n", pname);
+		usage(argv[0]);
+	}
+
+	if (opt_n == 0 && opt_k > 0) {
+		fprintf(stderr, "%s: -k can only be used with -n!\n", pname);
+		usage(argv[0]);
+	}
+
+	if (opt_c > 0 && opt_n == 0 && opt_d == 0) {
+		fprintf(stderr, "%s: -c can only be used with -n or -d!\n", pname);
+		usage(argv[0]);
+	}
+
+	if (opt_l > 0 && opt_d == 0) {
+		fprintf(stderr, "%s: -l can only be used with -d!\n", pname);
+		usage(argv[0]);
+	}
+
+	if (opt_d == 0 && (argc-optind)!=1) {
 		fprintf(stderr, "%s: You have to specify ONE URL!\n", pname);
 		usage(argv[0]);
 	}
@@ -221,24 +372,62 @@ int* urlinfo(char* url) {
 	if (opt_p==0) port = "80";
 	else port = p_arg;
 
-	url = argv[optind];
+	char* end;
+	long concurrency = opt_n ? 1 : FETCH_CONCURRENCY;
+	if (opt_c) {
+		concurrency = strtol(c_arg, &end, 10);
+		if (*end != '\0' || concurrency < 1 || concurrency > 1000000) {
+			fprintf(stderr, "%s: Invalid concurrency: %s\n", pname, c_arg);
+			usage(argv[0]);
+		}
+	}
 
-	FILE* outfile;
 	if (opt_d) {
-		int* p = urlinfo(url);
-		char* fn = malloc(strlen(url)+10);
-		strncpy(fn, url+p[2], strlen(url)+1-p[2]);
-		strcat(fn, "index.html");
-
-		char *path = malloc(sizeof(char)*(strlen(fn)+strlen(d_arg)+1));
-		strcpy(path, d_arg);
-		strcat(path, fn);
-		if ((outfile = fopen(path, "w")) == NULL) {
-			fprintf(stderr, "%s: Could not open file: %s\n", pname, path);
-			exit(EXIT_FAILURE);
+		char** urls = NULL;
+		int count = 0;
+		if (opt_l) {
+			FILE* list = strcmp(l_arg, "-") == 0 ? stdin : fopen(l_arg, "r");
+			if (list == NULL) {
+				fprintf(stderr, "%s: Could not open file: %s\n", pname, l_arg);
+				exit(EXIT_FAILURE);
+			}
+			read_urls(list, &urls, &count);
+			if (list != stdin) fclose(list);
 		}
-		free(path);
-	} else if (opt_o) {
+		for (int i = optind; i < argc; i++) {
+			urls = realloc(urls, sizeof(char*) * (count + 1));
+			urls[count++] = strdup(argv[i]);
+		}
+		if (count == 0) {
+			fprintf(stderr, "%s: You have to specify at least one URL!\n", pname);
+			usage(argv[0]);
+		}
+
+		int res = fetch(urls, count, port, d_arg, concurrency);
+		for (int i = 0; i < count; i++) free(urls[i]);
+		free(urls);
+		return res;
+	}
+
+	url = argv[optind];
+
+	if (opt_n) {
+		char *hostname, *file;
+		long requests = strtol(n_arg, &end, 10);
+		if (*end != '\0' || requests < 1) {
+			fprintf(stderr, "%s: Invalid number of requests: %s\n", pname, n_arg);
+			usage(argv[0]);
+		}
+
+		split_url(url, &hostname, &file);
+		int res = loadgen(hostname, port, file, requests, concurrency, opt_k);
+		free(hostname);
+		free(file);
+		return res;
+	}
+
+	FILE* outfile;
+	if (opt_o) {
 		if ((outfile = fopen(o_arg, "w")) == NULL) {
 			fprintf(stderr, "%s: Could not open file: %s\n", pname, o_arg);
 			exit(EXIT_FAILURE);
@@ -248,8 +437,8 @@ int* urlinfo(char* url) {
 
 
 	// fprintf(stderr, "%s: URL: %s, PORT: %s\n", pname, url, port);
-	request(url, port, outfile);
+	int res = request(url, port, outfile);
 
 	fclose(outfile);
-	return EXIT_SUCCESS;
+	return res;
 }
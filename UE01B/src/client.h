@@ -10,9 +10,37 @@
 #ifndef CLIENT_H_   /* Include guard */
 #define CLIENT_H_
 
+#include <stdio.h>
+
+#include "http_response.h"
+
+#define BUF_SIZE 65536      // receive buffer of the client
+
 int* urlinfo(char* url);
+void split_url(char* url, char** host, char** file);
 int request(char* url, char* port, FILE* outfile);
-void send_request(FILE* sockfile, char* host, char* file);
-void receive_header(FILE* sockfile);
+void send_request(int sockfd, char* host, char* file);
+
+/**
+ * @brief receives and checks the header of the response, exits with 2 on a protocol error and with 3 if the status is not 200
+ *
+ * @param sockfd the connected socket
+ * @param buf buffer of BUF_SIZE bytes, holds the first bytes of the body afterwards
+ * @param resp the parsed header
+ * @return number of body bytes in buf
+ */
+size_t receive_header(int sockfd, char* buf, http_response* resp);
+
+/**
+ * @brief streams the body of the response to a file, decoding chunked bodies
+ *
+ * @param sockfd the connected socket
+ * @param outfd the output file
+ * @param buf buffer of BUF_SIZE bytes, holding the first len bytes of the body
+ * @param len number of bytes in buf
+ * @param resp the parsed header
+ * @return 0 on success, -1 on failure
+ */
+int receive_body(int sockfd, int outfd, char* buf, size_t len, http_response* resp);
 
 #endif // CLIENT_H_
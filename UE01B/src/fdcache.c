@@ -0,0 +1,154 @@
+/**
+ * @file fdcache.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief A bounded LRU cache of open files and their stat
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fdcache.h"
+
+/** @brief FNV-1a hash of a path */
+static size_t hash_path(const char* path) {
+    size_t h = 2166136261u;
+    for (; *path; path++) h = (h ^ (unsigned char)*path) * 16777619u;
+    return h % FD_CACHE_BUCKETS;
+}
+
+/** @brief closes the file of an entry and frees it */
+static void free_entry(fd_entry* f) {
+    if (f->fd >= 0) close(f->fd);
+    free(f->path);
+    free(f);
+}
+
+/** @brief moves an entry to the front of the LRU list */
+static void lru_push(fdcache* fc, fd_entry* f) {
+    f->prev = NULL;
+    f->next = fc->head;
+    if (fc->head) fc->head->prev = f;
+    else fc->tail = f;
+    fc->head = f;
+}
+
+/** @brief removes an entry from the LRU list */
+static void lru_unlink(fdcache* fc, fd_entry* f) {
+    if (f->prev) f->prev->next = f->next;
+    else fc->head = f->next;
+    if (f->next) f->next->prev = f->prev;
+    else fc->tail = f->prev;
+}
+
+/**
+ * @brief Removes an entry from the cache
+ * @details The file is closed as soon as no connection references it anymore.
+ */
+static void remove_entry(fdcache* fc, fd_entry* f) {
+    fd_entry** p = &fc->buckets[hash_path(f->path)];
+    while (*p != f) p = &(*p)->hnext;
+    *p = f->hnext;
+
+    lru_unlink(fc, f);
+    fc->count--;
+
+    f->stale = 1;
+    if (f->refs == 0) free_entry(f);
+}
+
+/**
+ * @brief Opens a path and fills an entry with the result
+ *
+ * @param f the entry, whose path is set
+ */
+static void open_entry(fd_entry* f) {
+    f->fd = -1;
+    while ((f->fd = open(f->path, O_RDONLY | O_CLOEXEC)) < 0 && errno == EINTR);
+    if (f->fd < 0) {
+        f->err = errno;
+        return;
+    }
+    if (fstat(f->fd, &f->st) < 0 || !S_ISREG(f->st.st_mode)) {
+        f->err = S_ISDIR(f->st.st_mode) ? EISDIR : ENOENT;
+        close(f->fd);
+        f->fd = -1;
+    }
+}
+
+/**
+ * @brief Checks whether the path of an entry still leads to the same file
+ *
+ * @param f the entry
+ * @return 1 if the entry is still valid
+ */
+static int entry_valid(fd_entry* f) {
+    struct stat st;
+    if (stat(f->path, &st) < 0) return f->fd < 0; // still missing
+    if (f->fd < 0) return !S_ISREG(st.st_mode); // still no regular file
+    return st.st_ino == f->st.st_ino && st.st_dev == f->st.st_dev && st.st_size == f->st.st_size &&
+        st.st_mtim.tv_sec == f->st.st_mtim.tv_sec && st.st_mtim.tv_nsec == f->st.st_mtim.tv_nsec;
+}
+
+fdcache* fdcache_create(void) {
+    return calloc(1, sizeof(fdcache));
+}
+
+void fdcache_destroy(fdcache* fc) {
+    if (fc == NULL) return;
+    while (fc->head) remove_entry(fc, fc->head);
+    free(fc);
+}
+
+fd_entry* fdcache_open(fdcache* fc, const char* path, time_t now) {
+    size_t b = hash_path(path);
+    fd_entry* f = fc->buckets[b];
+    while (f && strcmp(f->path, path) != 0) f = f->hnext;
+
+    if (f && now - f->checked >= FD_CACHE_TTL) {
+        if (entry_valid(f)) f->checked = now;
+        else {
+            remove_entry(fc, f);
+            f = NULL;
+        }
+    }
+
+    if (f) {
+        lru_unlink(fc, f);
+    } else {
+        if (fc->count >= FD_CACHE_ENTRIES) remove_entry(fc, fc->tail);
+        if ((f = calloc(1, sizeof(fd_entry))) == NULL || (f->path = strdup(path)) == NULL) {
+            free(f);
+            errno = ENOMEM;
+            return NULL;
+        }
+        open_entry(f);
+        if (f->fd < 0 && f->err != ENOENT && f->err != ENOTDIR && f->err != EISDIR && f->err != EACCES) {
+            /* errors like EMFILE are temporary and must not be cached */
+            int err = f->err;
+            free_entry(f);
+            errno = err;
+            return NULL;
+        }
+        f->checked = now;
+        f->hnext = fc->buckets[b];
+        fc->buckets[b] = f;
+        fc->count++;
+    }
+    lru_push(fc, f);
+
+    if (f->fd < 0) {
+        errno = f->err;
+        return NULL;
+    }
+    f->refs++;
+    return f;
+}
+
+void fdcache_release(fd_entry* f) {
+    if (--f->refs == 0 && f->stale) free_entry(f);
+}
@@ -0,0 +1,72 @@
+/**
+ * @file fdcache.h
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief A bounded LRU cache of open files and their stat
+ * @details Repeated requests for the same path reuse the open file instead
+ * of walking the directories and opening it again. Paths which don't exist
+ * or aren't regular files are cached as well, so a missing file (e.g. the
+ * precompressed sibling of a file) costs no system call either. Entries are
+ * validated with a single stat at most every FD_CACHE_TTL seconds and are
+ * reopened if the file has been modified, replaced or deleted. Every worker
+ * has its own cache, so no locking is needed.
+ */
+#ifndef FDCACHE_H_   /* Include guard */
+#define FDCACHE_H_
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+
+#define FD_CACHE_ENTRIES 256    // max. number of paths cached by a worker
+#define FD_CACHE_BUCKETS 512    // number of buckets of the hash table
+#define FD_CACHE_TTL 1          // seconds an entry is used without validating it
+
+/** @brief an open file, or a path without a regular file */
+typedef struct fd_entry {
+    char* path;                 /** normalized path of the file, key of the entry */
+    int fd;                     /** the open file, -1 if there is none */
+    int err;                    /** errno of opening the file, if fd is -1 */
+    struct stat st;             /** stat of the open file */
+    time_t checked;             /** last time the entry was validated against the path */
+    int refs;                   /** number of connections still sending from fd */
+    int stale;                  /** set once the entry has been removed from the cache */
+    struct fd_entry* hnext;     /** next entry in the same bucket */
+    struct fd_entry* prev;      /** more recently used entry */
+    struct fd_entry* next;      /** less recently used entry */
+} fd_entry;
+
+/** @brief the cache of a worker */
+typedef struct fdcache {
+    fd_entry* buckets[FD_CACHE_BUCKETS];    /** hash table of all entries */
+    fd_entry* head;                         /** most recently used entry */
+    fd_entry* tail;                         /** least recently used entry */
+    int count;                              /** number of entries */
+} fdcache;
+
+/**
+ * @brief Creates an empty cache
+ *
+ * @return the cache or NULL if no memory is available
+ */
+fdcache* fdcache_create(void);
+
+/** @brief Frees a cache and closes all files which aren't referenced anymore, does nothing if fc is NULL */
+void fdcache_destroy(fdcache* fc);
+
+/**
+ * @brief Opens a regular file through the cache and references its entry
+ *
+ * @param fc the cache
+ * @param path normalized path of the file
+ * @param now the current time
+ * @return the referenced entry or NULL if the path isn't a regular file or
+ * no memory is available (errno is set)
+ */
+fd_entry* fdcache_open(fdcache* fc, const char* path, time_t now);
+
+/** @brief Drops a reference on an entry, the file is closed with the last reference of a removed entry */
+void fdcache_release(fd_entry* f);
+
+#endif // FDCACHE_H_
@@ -0,0 +1,556 @@
+/**
+ * @file fetch.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Parallel download of multiple URLs into a directory
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "client.h"
+#include "fetch.h"
+#include "http_response.h"
+
+/** @brief kinds of failed downloads, they decide the exit code */
+enum { F_ERROR, F_PROTOCOL, F_STATUS };
+
+/** @brief state of a download run */
+typedef struct fetch_run {
+    int epfd;                   /** epoll instance watching all connections */
+    char* port;                 /** the port to connect to */
+    fetch_host* hosts;          /** all hosts with the files to download from them */
+    fetch_conn* conns;          /** the connections */
+    int concurrency;            /** number of entries in conns */
+    int open;                   /** number of open connections */
+    long completed;             /** number of downloaded files */
+    long failed[3];             /** number of failed downloads per kind */
+    long long bytes;            /** bytes written to the output files */
+} fetch_run;
+
+/** @brief returns the current time in nanoseconds */
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** @brief frees a job */
+static void free_job(fetch_job* job) {
+    free(job->url);
+    free(job->file);
+    free(job->path);
+    free(job);
+}
+
+/**
+ * @brief Reports a failed download and frees the job
+ *
+ * @param run the download run
+ * @param job the job
+ * @param kind F_ERROR, F_PROTOCOL or F_STATUS
+ * @param reason description of the error
+ */
+static void fail_job(fetch_run* run, fetch_job* job, int kind, const char* reason) {
+    fprintf(stderr, "%s: %s\n", job->url, reason);
+    run->failed[kind]++;
+    free_job(job);
+}
+
+/**
+ * @brief Creates a job for an URL and adds it to the queue of its host
+ *
+ * @param run the download run
+ * @param url the URL
+ * @param dir the output directory
+ * @return 0 on success, -1 if the URL can't be stored below dir
+ */
+static int add_job(fetch_run* run, char* url, char* dir) {
+    fetch_job* job = calloc(1, sizeof(fetch_job));
+    char* host;
+    job->url = strdup(url);
+    split_url(url, &host, &job->file);
+
+    /* the query and the fragment are not part of the file name */
+    size_t len = strcspn(job->file, "?#");
+    int dirlen = strlen(dir);
+    while (dirlen > 1 && dir[dirlen-1] == '/') dirlen--;
+    job->path = malloc(dirlen + len + sizeof("index.html"));
+    sprintf(job->path, "%.*s%.*s%s", dirlen, dir, (int)len, job->file,
+        job->file[len-1] == '/' ? "index.html" : "");
+
+    /* never write outside of dir */
+    char* seg = job->path + dirlen;
+    if (host[0] == '\0' || strstr(seg, "/../") != NULL ||
+        (strlen(seg) >= 3 && strcmp(seg + strlen(seg) - 3, "/..") == 0)) {
+        free(host);
+        fail_job(run, job, F_ERROR, "Invalid URL");
+        return -1;
+    }
+
+    fetch_host* h = run->hosts;
+    while (h != NULL && strcmp(h->name, host) != 0) h = h->next;
+    if (h == NULL) {
+        h = calloc(1, sizeof(fetch_host));
+        h->name = host;
+        h->next = run->hosts;
+        run->hosts = h;
+    } else free(host);
+
+    if (h->tail != NULL) h->tail->next = job;
+    else h->head = job;
+    h->tail = job;
+    return 0;
+}
+
+/** @brief reports all jobs of a host as failed */
+static void fail_host(fetch_run* run, fetch_host* h, const char* reason) {
+    while (h->head != NULL) {
+        fetch_job* job = h->head;
+        h->head = job->next;
+        fail_job(run, job, F_ERROR, reason);
+    }
+    h->tail = NULL;
+}
+
+/** @brief closes the output file of a connection, deletes it, if the download failed */
+static void close_output(fetch_conn* c, int failed) {
+    if (c->out_fd < 0) return;
+    close(c->out_fd);
+    c->out_fd = -1;
+    if (failed) unlink(c->job->path);
+}
+
+/** @brief closes the pipe used for splicing bodies */
+static void close_pipe(fetch_conn* c) {
+    if (c->pipefd[0] < 0) return;
+    close(c->pipefd[0]);
+    close(c->pipefd[1]);
+    c->pipefd[0] = c->pipefd[1] = -1;
+}
+
+/** @brief closes a connection */
+static void fetch_close(fetch_run* run, fetch_conn* c) {
+    if (c->fd < 0) return;
+    close(c->fd);
+    c->fd = -1;
+    c->host->conns--;
+    c->host = NULL;
+    run->open--;
+}
+
+/**
+ * @brief Takes the next job of the host of a connection and prepares its request
+ *
+ * @param c the connection
+ * @return 0 on success, -1 if there is no job left
+ */
+static int next_job(fetch_conn* c) {
+    fetch_host* h = c->host;
+    if (h->head == NULL) return -1;
+    c->job = h->head;
+    h->head = c->job->next;
+    if (h->head == NULL) h->tail = NULL;
+    c->job->next = NULL;
+
+    /* let the server close the connection after the last file */
+    free(c->request);
+    c->request = malloc(strlen(c->job->file) + strlen(h->name) + 64);
+    c->request_len = sprintf(c->request, "GET %s HTTP/1.1\r\nHost: %s\r\n%s\r\n", c->job->file, h->name,
+        h->head == NULL ? "Connection: close\r\n" : "");
+    c->sent = 0;
+    c->len = 0;
+    c->header_done = 0;
+    c->status = 0;
+    c->body_left = -1;
+    c->keep_alive = 0;
+    c->out_fd = -1;
+    c->state = FETCH_SENDING;
+    return 0;
+}
+
+/**
+ * @brief Opens a connection to a host and starts its first job
+ *
+ * @param run the download run
+ * @param c the connection
+ * @param h the host
+ */
+static void fetch_connect(fetch_run* run, fetch_conn* c, fetch_host* h) {
+    if (h->ai == NULL) {
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof hints);
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+
+        int res = getaddrinfo(h->name, run->port, &hints, &h->ai);
+        if (res != 0) {
+            h->ai = NULL;
+            fail_host(run, h, gai_strerror(res));
+            return;
+        }
+    }
+
+    c->fd = socket(h->ai->ai_family, h->ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, h->ai->ai_protocol);
+    if (c->fd < 0) {
+        fail_host(run, h, strerror(errno));
+        return;
+    }
+    c->host = h;
+    h->conns++;
+    run->open++;
+    next_job(c);
+    c->reused = 0;
+    c->state = FETCH_CONNECTING;
+
+    struct epoll_event ev;
+    ev.events = EPOLLOUT;
+    ev.data.ptr = c;
+    if ((connect(c->fd, h->ai->ai_addr, h->ai->ai_addrlen) < 0 && errno != EINPROGRESS) ||
+        epoll_ctl(run->epfd, EPOLL_CTL_ADD, c->fd, &ev) < 0) {
+        fail_job(run, c->job, F_ERROR, strerror(errno));
+        c->job = NULL;
+        fetch_close(run, c);
+    }
+}
+
+/**
+ * @brief Opens connections for waiting jobs until the connection limit is reached
+ * @details Hosts with the fewest open connections are served first, so the
+ * connections are spread evenly over the hosts.
+ *
+ * @param run the download run
+ */
+static void fetch_fill(fetch_run* run) {
+    for (int i = 0; i < run->concurrency; i++) {
+        fetch_conn* c = &run->conns[i];
+        while (c->fd < 0) {
+            fetch_host* best = NULL;
+            for (fetch_host* h = run->hosts; h != NULL; h = h->next)
+                if (h->head != NULL && (best == NULL || h->conns < best->conns)) best = h;
+            if (best == NULL) return;
+            fetch_connect(run, c, best);
+        }
+    }
+}
+
+/**
+ * @brief Finishes the current job and continues with the next job of the same host
+ * @details The connection is closed, if it can't be reused or the host has no
+ * jobs left.
+ *
+ * @param run the download run
+ * @param c the connection
+ */
+static void finish_job(fetch_run* run, fetch_conn* c) {
+    if (c->status == 200) {
+        close_output(c, 0);
+        run->completed++;
+        free_job(c->job);
+    } else {
+        char reason[64];
+        snprintf(reason, sizeof(reason), "Server answered with status %i", c->status);
+        fail_job(run, c->job, F_STATUS, reason);
+    }
+    c->job = NULL;
+
+    if (!c->keep_alive || next_job(c) < 0) {
+        fetch_close(run, c);
+        return;
+    }
+    c->reused = 1;
+
+    struct epoll_event ev;
+    ev.events = EPOLLOUT;
+    ev.data.ptr = c;
+    if (epoll_ctl(run->epfd, EPOLL_CTL_MOD, c->fd, &ev) < 0) {
+        fail_job(run, c->job, F_ERROR, strerror(errno));
+        c->job = NULL;
+        fetch_close(run, c);
+    }
+}
+
+/**
+ * @brief Aborts the current job of a connection and closes the connection
+ * @details If a reused connection was closed before the response started,
+ * the server has closed the idle connection and the request is retried.
+ *
+ * @param run the download run
+ * @param c the connection
+ * @param kind F_ERROR or F_PROTOCOL
+ * @param reason description of the error
+ */
+static void abort_job(fetch_run* run, fetch_conn* c, int kind, const char* reason) {
+    fetch_job* job = c->job;
+    close_output(c, 1);
+    close_pipe(c); // may still hold bytes of a failed splice
+    c->job = NULL;
+
+    if (kind == F_ERROR && c->reused && c->len == 0 && !c->header_done && job->retries < FETCH_RETRIES) {
+        fetch_host* h = c->host;
+        job->retries++;
+        job->next = h->head;
+        h->head = job;
+        if (h->tail == NULL) h->tail = job;
+    } else fail_job(run, job, kind, reason);
+    fetch_close(run, c);
+}
+
+/**
+ * @brief Creates the output file and all missing directories on its path
+ *
+ * @param c the connection
+ * @return 0 on success, -1 on failure
+ */
+static int open_output(fetch_conn* c) {
+    char* path = c->job->path;
+    for (char* s = strchr(path + 1, '/'); s != NULL; s = strchr(s + 1, '/')) {
+        *s = '\0';
+        int res = mkdir(path, 0755);
+        *s = '/';
+        if (res < 0 && errno != EEXIST) return -1;
+    }
+    c->out_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (c->out_fd < 0) return -1;
+
+    /* without a pipe the body is copied with read and write */
+    if (c->pipefd[0] < 0 && pipe2(c->pipefd, O_CLOEXEC | O_NONBLOCK) < 0) c->pipefd[0] = c->pipefd[1] = -1;
+    return 0;
+}
+
+/**
+ * @brief Writes a part of the body to the output file
+ *
+ * @param run the download run
+ * @param c the connection
+ * @param buf the bytes
+ * @param n number of bytes
+ * @return 0 on success, -1 on failure
+ */
+static int write_body(fetch_run* run, fetch_conn* c, const char* buf, size_t n) {
+    if (c->body_left >= 0) c->body_left -= n;
+    if (c->out_fd < 0) return 0; // the body of an error response is discarded
+
+    while (n > 0) {
+        ssize_t w = write(c->out_fd, buf, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += w;
+        n -= w;
+        run->bytes += w;
+    }
+    return 0;
+}
+
+/**
+ * @brief Parses the header of a response as soon as it is complete
+ *
+ * @param c the connection
+ * @return 1 if the header is complete, 0 if more bytes are needed, -1 on a protocol error
+ */
+static int parse_header(fetch_conn* c) {
+    http_response resp;
+    int res = http_parse_response(&resp, c->buf, c->len);
+    if (res == 0) return c->len < FETCH_BUF_SIZE ? 0 : -1;
+    if (res < 0) return -1;
+
+    c->status = resp.status;
+    c->body_left = resp.content_length;
+    c->chunked = resp.chunked;
+    c->keep_alive = resp.keep_alive;
+    if (c->chunked) http_chunked_init(&c->chunk);
+
+    c->header_done = 1;
+    c->len -= resp.header_len;
+    memmove(c->buf, c->buf + resp.header_len, c->len);
+    return 1;
+}
+
+/**
+ * @brief Advances the state of a connection after epoll reported an event
+ *
+ * @param run the download run
+ * @param c the connection
+ */
+static void fetch_event(fetch_run* run, fetch_conn* c) {
+    if (c->fd < 0) return; // closed while handling an earlier event of the same batch
+
+    if (c->state == FETCH_CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+            abort_job(run, c, F_ERROR, strerror(err ? err : errno));
+            return;
+        }
+        c->state = FETCH_SENDING;
+    }
+
+    if (c->state == FETCH_SENDING) {
+        ssize_t n = send(c->fd, c->request + c->sent, c->request_len - c->sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) abort_job(run, c, F_ERROR, strerror(errno));
+            return;
+        }
+        c->sent += n;
+        if (c->sent < c->request_len) return;
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (epoll_ctl(run->epfd, EPOLL_CTL_MOD, c->fd, &ev) < 0) abort_job(run, c, F_ERROR, strerror(errno));
+        else c->state = FETCH_RECEIVING;
+        return;
+    }
+
+    for (;;) {
+        ssize_t n;
+        if (c->header_done && c->out_fd >= 0 && !c->chunked && c->pipefd[0] >= 0) {
+            /* move the body to the file without copying it through userspace */
+            size_t max = c->body_left < 0 || c->body_left > HTTP_SPLICE_MAX ? HTTP_SPLICE_MAX : c->body_left;
+            n = http_splice(c->fd, c->out_fd, c->pipefd, max);
+            if (n > 0) {
+                run->bytes += n;
+                if (c->body_left >= 0) c->body_left -= n;
+                if (c->body_left == 0) {
+                    finish_job(run, c);
+                    return;
+                }
+                continue;
+            }
+        } else if (c->header_done) n = read(c->fd, c->buf, FETCH_BUF_SIZE);
+        else n = read(c->fd, c->buf + c->len, FETCH_BUF_SIZE - c->len);
+
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) abort_job(run, c, F_ERROR, strerror(errno));
+            return;
+        }
+        if (n == 0) {
+            /* the server closed the connection, fine if the body ends with it */
+            if (c->header_done && c->body_left < 0 && !c->chunked) {
+                c->keep_alive = 0;
+                finish_job(run, c);
+            } else if (c->len == 0 && !c->header_done) abort_job(run, c, F_ERROR, "Connection closed by the server");
+            else abort_job(run, c, F_PROTOCOL, "Protocol error!");
+            return;
+        }
+
+        size_t avail = n;
+        if (!c->header_done) {
+            c->len += n;
+            int res = parse_header(c);
+            if (res == 0) continue;
+            if (res < 0) {
+                abort_job(run, c, F_PROTOCOL, "Protocol error!");
+                return;
+            }
+            /* error responses without a length can't be skipped */
+            if (c->status != 200 && c->body_left < 0 && !c->chunked) {
+                finish_job(run, c);
+                return;
+            }
+            if (c->status == 200 && open_output(c) < 0) {
+                abort_job(run, c, F_ERROR, strerror(errno));
+                return;
+            }
+            avail = c->len;
+        }
+
+        if (c->chunked) {
+            ssize_t m = http_decode_chunked(&c->chunk, c->buf, avail);
+            if (m < 0 || (c->chunk.done && c->chunk.used < avail)) {
+                abort_job(run, c, F_PROTOCOL, "Protocol error!");
+                return;
+            }
+            avail = m;
+        } else if (c->body_left >= 0 && (long long)avail > c->body_left) { // more bytes than announced
+            abort_job(run, c, F_PROTOCOL, "Protocol error!");
+            return;
+        }
+        if (write_body(run, c, c->buf, avail) < 0) {
+            abort_job(run, c, F_ERROR, strerror(errno));
+            return;
+        }
+        if (c->body_left == 0 || (c->chunked && c->chunk.done)) {
+            finish_job(run, c);
+            return;
+        }
+    }
+}
+
+int fetch(char** urls, int count, char* port, char* dir, int concurrency) {
+    fetch_run run;
+    memset(&run, 0, sizeof(run));
+    run.port = port;
+
+    for (int i = 0; i < count; i++) add_job(&run, urls[i], dir);
+
+    if (concurrency > count) concurrency = count > 0 ? count : 1;
+    run.concurrency = concurrency;
+    run.conns = calloc(concurrency, sizeof(fetch_conn));
+    run.epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (run.conns == NULL || run.epfd < 0) {
+        fprintf(stderr, "Failed to set up connections: %s\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < concurrency; i++) {
+        run.conns[i].fd = -1;
+        run.conns[i].out_fd = -1;
+        run.conns[i].pipefd[0] = run.conns[i].pipefd[1] = -1;
+    }
+
+    double start = now_ns();
+    fetch_fill(&run);
+
+    struct epoll_event events[256];
+    while (run.open > 0) {
+        int n = epoll_wait(run.epfd, events, 256, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Failed to wait for events: %s\n", strerror(errno));
+            break;
+        }
+        for (int i = 0; i < n; i++) fetch_event(&run, events[i].data.ptr);
+        fetch_fill(&run);
+    }
+    double s = (now_ns() - start) / 1e9;
+
+    long failed = run.failed[F_ERROR] + run.failed[F_PROTOCOL] + run.failed[F_STATUS];
+    printf("Downloaded %li of %i files (%lli bytes) in %.3f s, %.2f MB/s\n",
+        run.completed, count, run.bytes, s, run.bytes / s / 1e6);
+
+    for (int i = 0; i < concurrency; i++) {
+        fetch_conn* c = &run.conns[i];
+        if (c->job != NULL) abort_job(&run, c, F_ERROR, "Aborted");
+        fetch_close(&run, c);
+        close_pipe(c);
+        free(c->request);
+    }
+    while (run.hosts != NULL) {
+        fetch_host* h = run.hosts;
+        run.hosts = h->next;
+        fail_host(&run, h, "Aborted");
+        if (h->ai != NULL) freeaddrinfo(h->ai);
+        free(h->name);
+        free(h);
+    }
+    close(run.epfd);
+    free(run.conns);
+
+    if (run.failed[F_PROTOCOL]) return 2;
+    if (run.failed[F_STATUS]) return 3;
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file fetch.h
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Parallel download of multiple URLs into a directory
+ * @details All URLs are fetched from a single thread with non-blocking sockets
+ * and epoll. Every host is resolved only once and its files are requested one
+ * after another over keep-alive connections, while up to a fixed number of
+ * connections run in parallel. Bodies are written to the output files as they
+ * arrive.
+ */
+#ifndef FETCH_H_   /* Include guard */
+#define FETCH_H_
+
+#include <netdb.h>
+#include <stddef.h>
+
+#include "http_response.h"
+
+#define FETCH_BUF_SIZE 65536        // receive buffer of a connection
+#define FETCH_CONCURRENCY 4         // default number of parallel connections
+#define FETCH_RETRIES 1             // retries of a request, whose reused connection was closed by the server
+
+/** @brief the phases a connection goes through */
+typedef enum fetch_state {
+    FETCH_CONNECTING,   /** waiting for the TCP handshake */
+    FETCH_SENDING,      /** sending the request */
+    FETCH_RECEIVING     /** receiving the response */
+} fetch_state;
+
+/** @brief a file to download */
+typedef struct fetch_job {
+    char* url;                  /** the URL as given by the user */
+    char* file;                 /** the requested path */
+    char* path;                 /** the output file */
+    int retries;                /** number of times the request has been retried */
+    struct fetch_job* next;     /** next job of the same host */
+} fetch_job;
+
+/** @brief a host together with the files still to download from it */
+typedef struct fetch_host {
+    char* name;                 /** the hostname */
+    struct addrinfo* ai;        /** address of the host, NULL until it has been resolved */
+    fetch_job* head;            /** first job not yet started */
+    fetch_job* tail;            /** last job not yet started */
+    int conns;                  /** number of open connections to this host */
+    struct fetch_host* next;    /** next host */
+} fetch_host;
+
+/** @brief a connection to a host */
+typedef struct fetch_conn {
+    int fd;                     /** socket, -1 if the connection is closed */
+    fetch_state state;          /** current phase */
+    fetch_host* host;           /** the host the socket is connected to */
+    fetch_job* job;             /** the file currently requested */
+    int reused;                 /** the current request is not the first one on this socket */
+    char* request;              /** the current request */
+    size_t request_len;         /** length of request */
+    size_t sent;                /** bytes of the request allready sent */
+    char buf[FETCH_BUF_SIZE];   /** received bytes of the response header */
+    size_t len;                 /** number of bytes in buf */
+    int header_done;            /** set once the header of the response has been received */
+    int status;                 /** status code of the response */
+    long long body_left;        /** bytes of the body still to be received, -1 if it ends with the connection or is chunked */
+    int chunked;                /** the body uses the chunked transfer coding */
+    http_chunked chunk;         /** decoder of a chunked body */
+    int keep_alive;             /** the connection can be reused after the current response */
+    int out_fd;                 /** the output file, -1 if the body is discarded */
+    int pipefd[2];              /** pipe for splicing the body into out_fd, -1 if there is none */
+} fetch_conn;
+
+/**
+ * @brief Downloads URLs into a directory
+ * @details The path of an URL is recreated below dir, paths ending with '/'
+ * are stored as index.html. Errors are reported per URL on stderr.
+ *
+ * @param urls the URLs to download
+ * @param count number of URLs
+ * @param port the port to connect to
+ * @param dir the output directory
+ * @param concurrency max. number of parallel connections
+ * @return EXIT_SUCCESS if all files were downloaded, 2 on a protocol error,
+ *         3 if the server answered with another status than 200, else EXIT_FAILURE
+ */
+int fetch(char** urls, int count, char* port, char* dir, int concurrency);
+
+#endif // FETCH_H_
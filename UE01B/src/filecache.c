@@ -0,0 +1,182 @@
+/**
+ * @file filecache.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief A bounded LRU cache for small, frequently requested files
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "filecache.h"
+
+/** @brief FNV-1a hash of a path */
+static size_t hash_path(const char* path) {
+    size_t h = 2166136261u;
+    for (; *path; path++) h = (h ^ (unsigned char)*path) * 16777619u;
+    return h % CACHE_BUCKETS;
+}
+
+/** @brief frees an entry */
+static void free_entry(cache_entry* e) {
+    free(e->path);
+    free(e->data);
+    free(e);
+}
+
+/** @brief moves an entry to the front of the LRU list */
+static void lru_push(filecache* fc, cache_entry* e) {
+    e->prev = NULL;
+    e->next = fc->head;
+    if (fc->head) fc->head->prev = e;
+    else fc->tail = e;
+    fc->head = e;
+}
+
+/** @brief removes an entry from the LRU list */
+static void lru_unlink(filecache* fc, cache_entry* e) {
+    if (e->prev) e->prev->next = e->next;
+    else fc->head = e->next;
+    if (e->next) e->next->prev = e->prev;
+    else fc->tail = e->prev;
+}
+
+/**
+ * @brief Removes an entry from the cache
+ * @details The entry is freed as soon as no connection references it anymore.
+ */
+static void remove_entry(filecache* fc, cache_entry* e) {
+    cache_entry** p = &fc->buckets[hash_path(e->path)];
+    while (*p != e) p = &(*p)->hnext;
+    *p = e->hnext;
+
+    lru_unlink(fc, e);
+    fc->size -= e->header_len + 2 + e->size;
+
+    e->stale = 1;
+    if (e->refs == 0) free_entry(e);
+}
+
+filecache* cache_create(size_t limit) {
+    filecache* fc = calloc(1, sizeof(filecache));
+    if (fc) fc->limit = limit;
+    return fc;
+}
+
+void cache_destroy(filecache* fc) {
+    if (fc == NULL) return;
+    while (fc->head) remove_entry(fc, fc->head);
+    free(fc);
+}
+
+cache_entry* cache_lookup(filecache* fc, const char* path, time_t now) {
+    cache_entry* e = fc->buckets[hash_path(path)];
+    while (e && strcmp(e->path, path) != 0) e = e->hnext;
+    if (e == NULL) return NULL;
+
+    if (e->checked != now) {
+        struct stat st;
+        if (stat(path, &st) < 0 || st.st_ino != e->ino || st.st_size != e->file_size ||
+            st.st_mtim.tv_sec != e->mtime.tv_sec || st.st_mtim.tv_nsec != e->mtime.tv_nsec) {
+            remove_entry(fc, e);
+            return NULL;
+        }
+        e->checked = now;
+    }
+
+    lru_unlink(fc, e);
+    lru_push(fc, e);
+    e->refs++;
+    return e;
+}
+
+/**
+ * @brief Allocates an entry for a file and copies the header into it
+ *
+ * @param fc the cache
+ * @param path resolved path of the file
+ * @param st the stat of the file
+ * @param header the response header
+ * @param len length of the content
+ * @param now the current time
+ * @return the entry or NULL if it is too big or no memory is available
+ */
+static cache_entry* new_entry(filecache* fc, const char* path, struct stat* st, const char* header, size_t len, time_t now) {
+    size_t header_len = strlen(header);
+    size_t total = header_len + 2 + len;
+    if (len > CACHE_MAX_FILE || total > fc->limit) return NULL;
+
+    cache_entry* e = calloc(1, sizeof(cache_entry));
+    if (e == NULL) return NULL;
+    e->path = strdup(path);
+    e->data = malloc(total);
+    if (e->path == NULL || e->data == NULL) {
+        free_entry(e);
+        return NULL;
+    }
+
+    memcpy(e->data, header, header_len);
+    memcpy(e->data + header_len, "\r\n", 2);
+    e->header_len = header_len;
+    e->size = len;
+    e->file_size = st->st_size;
+    e->mtime = st->st_mtim;
+    e->ino = st->st_ino;
+    e->checked = now;
+    e->refs = 1;
+    return e;
+}
+
+/** @brief adds a new entry to the cache, evicting entries until it fits */
+static void add_entry(filecache* fc, cache_entry* e) {
+    size_t total = e->header_len + 2 + e->size;
+
+    /* replace an outdated entry of the same file and make room for the new one */
+    cache_entry* old = fc->buckets[hash_path(e->path)];
+    while (old && strcmp(old->path, e->path) != 0) old = old->hnext;
+    if (old) remove_entry(fc, old);
+    while (fc->size + total > fc->limit) remove_entry(fc, fc->tail);
+
+    size_t h = hash_path(e->path);
+    e->hnext = fc->buckets[h];
+    fc->buckets[h] = e;
+    lru_push(fc, e);
+    fc->size += total;
+}
+
+cache_entry* cache_insert(filecache* fc, const char* path, int fd, struct stat* st, const char* header, time_t now) {
+    if (st->st_size > CACHE_MAX_FILE) return NULL;
+    cache_entry* e = new_entry(fc, path, st, header, st->st_size, now);
+    if (e == NULL) return NULL;
+
+    char* content = e->data + e->header_len + 2;
+    for (off_t off = 0; off < st->st_size;) {
+        ssize_t n = pread(fd, content + off, st->st_size - off, off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            free_entry(e);
+            return NULL;
+        }
+        off += n;
+    }
+
+    add_entry(fc, e);
+    return e;
+}
+
+cache_entry* cache_insert_data(filecache* fc, const char* path, struct stat* st, const char* header,
+    const char* data, size_t len, time_t now) {
+    cache_entry* e = new_entry(fc, path, st, header, len, now);
+    if (e == NULL) return NULL;
+
+    if (len > 0) memcpy(e->data + e->header_len + 2, data, len);
+    add_entry(fc, e);
+    return e;
+}
+
+void cache_release(cache_entry* e) {
+    if (--e->refs == 0 && e->stale) free_entry(e);
+}
@@ -0,0 +1,108 @@
+/**
+ * @file filecache.h
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief A bounded LRU cache for small, frequently requested files
+ * @details Every entry holds the pre-rendered response header followed by
+ * the content of the file, so a hit can be sent without touching the file
+ * system. Entries are validated against the mtime of the file at most once
+ * per second. Every worker has its own caches, so no locking is needed.
+ * Besides the content of a file, an entry can hold data derived from it
+ * (e.g. the compressed content), which is dropped together with the file.
+ */
+#ifndef FILECACHE_H_   /* Include guard */
+#define FILECACHE_H_
+
+#include <stddef.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+
+#define CACHE_SIZE (32 << 20)       // max. number of bytes in the file cache of a worker
+#define CACHE_MAX_FILE (1 << 20)    // contents bigger than this are never cached
+#define CACHE_BUCKETS 1024          // number of buckets of the hash table
+
+/** @brief a cached file together with its response header */
+typedef struct cache_entry {
+    char* path;                 /** resolved path of the file, key of the entry */
+    char* data;                 /** header, followed by "\r\n" and the content */
+    size_t header_len;          /** length of the header in data (without "\r\n") */
+    size_t size;                /** length of the content */
+    off_t file_size;            /** length of the cached file */
+    struct timespec mtime;      /** modification time of the cached file */
+    ino_t ino;                  /** inode of the cached file */
+    time_t checked;             /** last time the entry was validated against the file */
+    int refs;                   /** number of connections still sending the entry */
+    int stale;                  /** set once the entry has been removed from the cache */
+    struct cache_entry* hnext;  /** next entry in the same bucket */
+    struct cache_entry* prev;   /** more recently used entry */
+    struct cache_entry* next;   /** less recently used entry */
+} cache_entry;
+
+/** @brief the cache of a worker */
+typedef struct filecache {
+    cache_entry* buckets[CACHE_BUCKETS];    /** hash table of all entries */
+    cache_entry* head;                      /** most recently used entry */
+    cache_entry* tail;                      /** least recently used entry */
+    size_t size;                            /** number of bytes used by all entries */
+    size_t limit;                           /** max. number of bytes used by all entries */
+} filecache;
+
+/**
+ * @brief Creates an empty cache
+ *
+ * @param limit max. number of bytes used by all entries
+ * @return the cache or NULL if no memory is available
+ */
+filecache* cache_create(size_t limit);
+
+/** @brief Frees a cache and all entries which aren't referenced anymore, does nothing if fc is NULL */
+void cache_destroy(filecache* fc);
+
+/**
+ * @brief Searches the cache for a file and references the entry
+ * @details The entry is checked against the file once per second and dropped
+ * if the file has been modified, replaced or deleted.
+ *
+ * @param fc the cache
+ * @param path resolved path of the file
+ * @param now the current time
+ * @return the referenced entry or NULL if the file isn't cached
+ */
+cache_entry* cache_lookup(filecache* fc, const char* path, time_t now);
+
+/**
+ * @brief Reads a file into the cache and references the new entry
+ * @details Least recently used entries are evicted until the file fits.
+ *
+ * @param fc the cache
+ * @param path resolved path of the file
+ * @param fd the opened file
+ * @param st the stat of the opened file
+ * @param header the pre-rendered response header (without the terminating empty line)
+ * @param now the current time
+ * @return the referenced entry or NULL if the file can't be cached
+ */
+cache_entry* cache_insert(filecache* fc, const char* path, int fd, struct stat* st, const char* header, time_t now);
+
+/**
+ * @brief Adds data derived from a file to the cache and references the new entry
+ * @details The entry is validated against the file like the entries of cache_insert.
+ *
+ * @param fc the cache
+ * @param path resolved path of the file
+ * @param st the stat of the file the data has been derived from
+ * @param header the pre-rendered response header (without the terminating empty line)
+ * @param data the content sent after the header
+ * @param len length of data
+ * @param now the current time
+ * @return the referenced entry or NULL if the data can't be cached
+ */
+cache_entry* cache_insert_data(filecache* fc, const char* path, struct stat* st, const char* header,
+    const char* data, size_t len, time_t now);
+
+/** @brief Drops the reference of a connection on an entry */
+void cache_release(cache_entry* e);
+
+#endif // FILECACHE_H_
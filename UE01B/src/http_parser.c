@@ -0,0 +1,191 @@
+/**
+ * @file http_parser.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief An incremental parser for HTTP request headers
+ */
+
+#include <string.h>
+#include <strings.h>
+
+#include "http_parser.h"
+
+/** @brief states of the parser */
+enum {
+    S_START,        /** skipping empty lines before the request line */
+    S_METHOD,       /** inside the method */
+    S_PATH,         /** inside the path */
+    S_VERSION,      /** inside the protocol version */
+    S_LINE_LF,      /** expecting '\n' after the request line */
+    S_NAME_START,   /** at the start of a header line */
+    S_NAME,         /** inside the name of a header field */
+    S_VALUE_START,  /** skipping whitespaces in front of a value */
+    S_VALUE,        /** inside a value */
+    S_HEADER_LF,    /** expecting '\n' after a header line */
+    S_END_LF,       /** expecting '\n' of the empty line */
+    S_DONE          /** the header has been parsed completely */
+};
+
+/** @brief token characters as defined by RFC 7230, allowed in methods and field names */
+static const char tchar[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 1, 0, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 0, 1, 0,
+};
+
+/** @brief control characters, which are not allowed in paths and values (tab is allowed in values) */
+#define IS_CTL(ch) ((unsigned char)(ch) < 0x20 || (ch) == 0x7f)
+
+void http_parser_init(http_request* r) {
+    r->header_count = 0;
+    r->length = 0;
+    r->state = S_START;
+    r->pos = 0;
+    r->mark = 0;
+}
+
+int http_parse_request(http_request* r, const char* buf, size_t len) {
+    size_t pos = r->pos;
+    int state = r->state;
+
+    if (state == S_DONE) return HTTP_PARSE_DONE;
+    while (pos < len) {
+        char ch = buf[pos];
+        switch (state) {
+        case S_START:
+            if (ch != '\r' && ch != '\n') {
+                r->mark = pos;
+                state = S_METHOD;
+                continue;
+            }
+            pos++;
+            break;
+
+        case S_METHOD:
+            while (pos < len && tchar[(unsigned char)buf[pos]]) pos++;
+            if (pos == len) break;
+            if (buf[pos] != ' ' || pos == r->mark) return HTTP_PARSE_ERROR;
+            r->method.ptr = buf + r->mark;
+            r->method.len = pos - r->mark;
+            r->mark = ++pos;
+            state = S_PATH;
+            break;
+
+        case S_PATH:
+            while (pos < len && buf[pos] != ' ' && !IS_CTL(buf[pos])) pos++;
+            if (pos == len) break;
+            if (buf[pos] != ' ' || pos == r->mark) return HTTP_PARSE_ERROR;
+            r->path.ptr = buf + r->mark;
+            r->path.len = pos - r->mark;
+            r->mark = ++pos;
+            state = S_VERSION;
+            break;
+
+        case S_VERSION:
+            while (pos < len && !IS_CTL(buf[pos]) && buf[pos] != ' ') pos++;
+            if (pos == len) break;
+            if ((buf[pos] != '\r' && buf[pos] != '\n') || pos - r->mark < 6 ||
+                memcmp(buf + r->mark, "HTTP/", 5) != 0)
+                return HTTP_PARSE_ERROR;
+            r->version.ptr = buf + r->mark;
+            r->version.len = pos - r->mark;
+            state = buf[pos++] == '\r' ? S_LINE_LF : S_NAME_START;
+            break;
+
+        case S_LINE_LF:
+        case S_HEADER_LF:
+            if (ch != '\n') return HTTP_PARSE_ERROR;
+            pos++;
+            state = S_NAME_START;
+            break;
+
+        case S_NAME_START:
+            if (ch == '\r' || ch == '\n') {
+                pos++;
+                state = ch == '\r' ? S_END_LF : S_DONE;
+                break;
+            }
+            if (r->header_count == HTTP_MAX_HEADERS) return HTTP_PARSE_ERROR;
+            r->mark = pos;
+            state = S_NAME;
+            break;
+
+        case S_NAME:
+            while (pos < len && tchar[(unsigned char)buf[pos]]) pos++;
+            if (pos == len) break;
+            if (buf[pos] != ':' || pos == r->mark) return HTTP_PARSE_ERROR;
+            r->headers[r->header_count].name.ptr = buf + r->mark;
+            r->headers[r->header_count].name.len = pos - r->mark;
+            pos++;
+            state = S_VALUE_START;
+            break;
+
+        case S_VALUE_START:
+            while (pos < len && (buf[pos] == ' ' || buf[pos] == '\t')) pos++;
+            if (pos == len) break;
+            r->mark = pos;
+            state = S_VALUE;
+            break;
+
+        case S_VALUE: {
+            while (pos < len && (!IS_CTL(buf[pos]) || buf[pos] == '\t')) pos++;
+            if (pos == len) break;
+            if (buf[pos] != '\r' && buf[pos] != '\n') return HTTP_PARSE_ERROR;
+
+            size_t end = pos;
+            while (end > r->mark && (buf[end-1] == ' ' || buf[end-1] == '\t')) end--;
+            r->headers[r->header_count].value.ptr = buf + r->mark;
+            r->headers[r->header_count].value.len = end - r->mark;
+            r->header_count++;
+            state = buf[pos++] == '\r' ? S_HEADER_LF : S_NAME_START;
+            break;
+        }
+
+        case S_END_LF:
+            if (ch != '\n') return HTTP_PARSE_ERROR;
+            pos++;
+            state = S_DONE;
+            break;
+        }
+
+        if (state == S_DONE) {
+            r->length = pos;
+            break;
+        }
+    }
+
+    r->pos = pos;
+    r->state = state;
+    return state == S_DONE ? HTTP_PARSE_DONE : HTTP_PARSE_AGAIN;
+}
+
+const http_slice* http_find_header(const http_request* r, const char* name) {
+    for (int i = 0; i < r->header_count; i++)
+        if (http_slice_caseeq(r->headers[i].name, name)) return &r->headers[i].value;
+    return NULL;
+}
+
+int http_slice_eq(http_slice s, const char* str) {
+    return strlen(str) == s.len && memcmp(s.ptr, str, s.len) == 0;
+}
+
+int http_slice_caseeq(http_slice s, const char* str) {
+    return strlen(str) == s.len && strncasecmp(s.ptr, str, s.len) == 0;
+}
+
+int http_slice_has_token(http_slice s, const char* token) {
+    size_t i = 0;
+    while (i < s.len) {
+        while (i < s.len && (s.ptr[i] == ' ' || s.ptr[i] == '\t' || s.ptr[i] == ',')) i++;
+        size_t start = i;
+        while (i < s.len && s.ptr[i] != ',') i++;
+        size_t end = i;
+        while (end > start && (s.ptr[end-1] == ' ' || s.ptr[end-1] == '\t')) end--;
+
+        http_slice t = { s.ptr + start, end - start };
+        if (t.len > 0 && http_slice_caseeq(t, token)) return 1;
+    }
+    return 0;
+}
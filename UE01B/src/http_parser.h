@@ -0,0 +1,100 @@
+/**
+ * @file http_parser.h
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief An incremental parser for HTTP request headers
+ * @details The parser works directly on the receive buffer of a connection
+ * and never allocates or copies: method, path, version and the headers are
+ * returned as slices pointing into the buffer. If the header is incomplete,
+ * the parser remembers its position and continues there once more bytes have
+ * been appended to the buffer.
+ */
+#ifndef HTTP_PARSER_H_   /* Include guard */
+#define HTTP_PARSER_H_
+
+#include <stddef.h>
+
+#define HTTP_MAX_HEADERS 32     // max. number of header fields in a request
+
+#define HTTP_PARSE_ERROR -1     // the request is malformed
+#define HTTP_PARSE_AGAIN 0      // the header is incomplete
+#define HTTP_PARSE_DONE 1       // the header has been parsed completely
+
+/** @brief a part of the buffer, which is not '\0' terminated */
+typedef struct http_slice {
+    const char* ptr;    /** first character */
+    size_t len;         /** number of characters */
+} http_slice;
+
+/** @brief a header field of a request */
+typedef struct http_header {
+    http_slice name;    /** name of the field */
+    http_slice value;   /** value without surrounding whitespaces */
+} http_header;
+
+/** @brief the parsed header of a request together with the state of the parser */
+typedef struct http_request {
+    http_slice method;                          /** request method */
+    http_slice path;                            /** requested path */
+    http_slice version;                         /** protocol version, e.g. "HTTP/1.1" */
+    http_header headers[HTTP_MAX_HEADERS];      /** header fields in the order received */
+    int header_count;                           /** number of entries in headers */
+    size_t length;                              /** length of the header including the empty line */
+    int state;                                  /** state of the parser */
+    size_t pos;                                 /** offset of the next byte to parse */
+    size_t mark;                                /** offset where the current element started */
+} http_request;
+
+/**
+ * @brief Resets the parser for a new request
+ *
+ * @param r the request
+ */
+void http_parser_init(http_request* r);
+
+/**
+ * @brief Continues parsing the header of a request
+ * @details buf has to contain the same bytes on every call for one request,
+ * only new bytes may be appended. The slices in r point into buf.
+ *
+ * @param r the request
+ * @param buf the received bytes of the request
+ * @param len number of bytes in buf
+ * @return HTTP_PARSE_DONE, HTTP_PARSE_AGAIN or HTTP_PARSE_ERROR
+ */
+int http_parse_request(http_request* r, const char* buf, size_t len);
+
+/**
+ * @brief Searches the header fields of a parsed request (case insensitive)
+ *
+ * @param r the request
+ * @param name name of the header field
+ * @return the value of the first field with that name or NULL if there is none
+ */
+const http_slice* http_find_header(const http_request* r, const char* name);
+
+/**
+ * @brief Compares a slice to a string
+ *
+ * @return 1 if both are equal, else 0
+ */
+int http_slice_eq(http_slice s, const char* str);
+
+/**
+ * @brief Compares a slice to a string ignoring the case
+ *
+ * @return 1 if both are equal, else 0
+ */
+int http_slice_caseeq(http_slice s, const char* str);
+
+/**
+ * @brief Checks, whether a comma separated list (e.g. of the Connection header) contains a token
+ *
+ * @param s the list
+ * @param token the token, compared case insensitive
+ * @return 1 if the token is in the list, else 0
+ */
+int http_slice_has_token(http_slice s, const char* token);
+
+#endif // HTTP_PARSER_H_
@@ -0,0 +1,183 @@
+/**
+ * @file http_response.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Parsing of HTTP responses for the client
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "http_response.h"
+
+/** @brief states of the chunk decoder */
+enum {
+    CH_SIZE,        /** inside the hexadecimal chunk size */
+    CH_EXT,         /** skipping chunk extensions up to the end of the line */
+    CH_DATA,        /** inside the data of a chunk */
+    CH_DATA_CR,     /** expecting the line break after the data */
+    CH_DATA_LF,     /** expecting '\n' after the data */
+    CH_TRAILER,     /** at the start of a trailer line */
+    CH_TRAILER_LINE,/** inside a trailer line */
+    CH_END_LF       /** expecting '\n' of the empty line ending the body */
+};
+
+/** @brief returns the value of a hex digit, -1 if ch is none */
+static int hexval(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+int http_parse_response(http_response* r, const char* buf, size_t len) {
+    const char* end = memmem(buf, len, "\r\n\r\n", 4);
+    if (end == NULL) return 0;
+    end += 4;
+
+    char* ptr;
+    if (end - buf < 13 || strncmp(buf, "HTTP/1.", 7) != 0 || buf[8] != ' ') return -1;
+    r->status = strtol(buf + 9, &ptr, 10);
+    if (ptr != buf + 12 || (*ptr != ' ' && *ptr != '\r')) return -1;
+    r->reason = *ptr == ' ' ? ptr + 1 : ptr;
+    r->reason_len = (const char*)memchr(buf, '\r', end - buf) - r->reason;
+    r->keep_alive = buf[7] == '1';
+    r->content_length = -1;
+    r->chunked = 0;
+
+    /* search the headers for the length of the body and the connection state */
+    for (const char* line = (const char*)memchr(buf, '\n', end - buf) + 1; line < end - 2;) {
+        const char* eol = memchr(line, '\n', end - line);
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            r->content_length = strtoll(line + 15, &ptr, 10);
+            if (ptr == line + 15 || r->content_length < 0) return -1;
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+            const char* v = line + 18;
+            while (*v == ' ' || *v == '\t') v++;
+            if (strncasecmp(v, "chunked", 7) != 0) return -1; // no other codings are supported
+            r->chunked = 1;
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            const char* v = line + 11;
+            while (*v == ' ' || *v == '\t') v++;
+            if (strncasecmp(v, "close", 5) == 0) r->keep_alive = 0;
+            else if (strncasecmp(v, "keep-alive", 10) == 0) r->keep_alive = 1;
+        }
+        line = eol + 1;
+    }
+    if (r->chunked) r->content_length = -1; // the chunks decide the length
+    else if (r->content_length < 0) r->keep_alive = 0; // the body ends with the connection
+
+    /* responses to errors and redirects without a body */
+    if (r->status == 204 || r->status == 304 || (r->status >= 100 && r->status < 200)) {
+        r->content_length = 0;
+        r->chunked = 0;
+    }
+    r->header_len = end - buf;
+    return 1;
+}
+
+void http_chunked_init(http_chunked* d) {
+    memset(d, 0, sizeof(http_chunked));
+    d->state = CH_SIZE;
+}
+
+ssize_t http_decode_chunked(http_chunked* d, char* buf, size_t len) {
+    size_t in = 0, out = 0;
+
+    while (in < len && !d->done) {
+        char ch = buf[in];
+        switch (d->state) {
+        case CH_SIZE: {
+            int v = hexval(ch);
+            if (v >= 0) {
+                if (d->left > (LLONG_MAX >> 4)) return -1;
+                d->left = d->left * 16 + v;
+                d->digits++;
+                in++;
+                break;
+            }
+            if (d->digits == 0 || (ch != ';' && ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n')) return -1;
+            d->state = CH_EXT;
+            break;
+        }
+
+        case CH_EXT:
+            in++;
+            if (ch == '\n') d->state = d->left > 0 ? CH_DATA : CH_TRAILER;
+            break;
+
+        case CH_DATA: {
+            size_t n = len - in < (unsigned long long)d->left ? len - in : (size_t)d->left;
+            memmove(buf + out, buf + in, n);
+            in += n;
+            out += n;
+            d->left -= n;
+            if (d->left == 0) d->state = CH_DATA_CR;
+            break;
+        }
+
+        case CH_DATA_CR:
+        case CH_DATA_LF:
+            if (ch == '\r' && d->state == CH_DATA_CR) d->state = CH_DATA_LF;
+            else if (ch == '\n') {
+                d->state = CH_SIZE;
+                d->digits = 0;
+            } else return -1;
+            in++;
+            break;
+
+        case CH_TRAILER:
+            in++;
+            if (ch == '\r') d->state = CH_END_LF;
+            else if (ch == '\n') d->done = 1;
+            else d->state = CH_TRAILER_LINE;
+            break;
+
+        case CH_TRAILER_LINE:
+            in++;
+            if (ch == '\n') d->state = CH_TRAILER;
+            break;
+
+        case CH_END_LF:
+            if (ch != '\n') return -1;
+            in++;
+            d->done = 1;
+            break;
+        }
+    }
+
+    d->used = in;
+    return out;
+}
+
+int http_write_all(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+ssize_t http_splice(int from, int to, int pipefd[2], size_t max) {
+    ssize_t n = splice(from, NULL, pipefd[1], NULL, max, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (n <= 0) return n;
+
+    for (ssize_t left = n; left > 0;) {
+        ssize_t m = splice(pipefd[0], NULL, to, NULL, left, SPLICE_F_MOVE);
+        if (m < 0 && errno == EINTR) continue;
+        if (m <= 0) return -1;
+        left -= m;
+    }
+    return n;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file http_response.h
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Parsing of HTTP responses for the client
+ * @details Parses the header of a response, decodes chunked bodies in place
+ * and moves bodies from a socket to a file with splice, so the body never
+ * has to be copied through userspace.
+ */
+#ifndef HTTP_RESPONSE_H_   /* Include guard */
+#define HTTP_RESPONSE_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define HTTP_SPLICE_MAX 65536   // max. bytes moved by one call of http_splice
+
+/** @brief the parsed header of a response */
+typedef struct http_response {
+    int status;                 /** status code */
+    const char* reason;         /** reason phrase, points into the buffer */
+    int reason_len;             /** length of the reason phrase */
+    long long content_length;   /** length of the body, -1 if it is not known */
+    int chunked;                /** the body uses the chunked transfer coding */
+    int keep_alive;             /** the connection can be reused after the body */
+    size_t header_len;          /** length of the header including the empty line */
+} http_response;
+
+/** @brief state of the decoder of a chunked body */
+typedef struct http_chunked {
+    int state;          /** current position in the chunk syntax */
+    long long left;     /** bytes of the current chunk still to be received */
+    int digits;         /** number of digits of the current chunk size */
+    int done;           /** set once the last chunk and the trailer have been received */
+    size_t used;        /** number of input bytes consumed by the last call */
+} http_chunked;
+
+/**
+ * @brief Parses the header of a response
+ *
+ * @param r the parsed response
+ * @param buf the received bytes
+ * @param len number of bytes in buf
+ * @return 1 if the header is complete, 0 if more bytes are needed, -1 on a protocol error
+ */
+int http_parse_response(http_response* r, const char* buf, size_t len);
+
+/**
+ * @brief Resets the decoder for a new body
+ *
+ * @param d the decoder
+ */
+void http_chunked_init(http_chunked* d);
+
+/**
+ * @brief Decodes received bytes of a chunked body in place
+ * @details The data of the chunks is moved to the start of buf, the chunk
+ * sizes, extensions and the trailer are dropped. Bytes after the end of the
+ * body are not consumed (see used).
+ *
+ * @param d the decoder
+ * @param buf the received bytes
+ * @param len number of bytes in buf
+ * @return number of data bytes at the start of buf, -1 on a protocol error
+ */
+ssize_t http_decode_chunked(http_chunked* d, char* buf, size_t len);
+
+/**
+ * @brief Writes a buffer completely
+ *
+ * @return 0 on success, -1 on failure
+ */
+int http_write_all(int fd, const char* buf, size_t len);
+
+/**
+ * @brief Moves bytes from a socket to a file or pipe without copying them through userspace
+ * @details The bytes pass through pipefd, which is empty again on return.
+ * If from is non-blocking, the call returns -1 with errno EAGAIN if no bytes
+ * are available.
+ *
+ * @param from the socket
+ * @param to the output file
+ * @param pipefd a pipe used as buffer
+ * @param max max. number of bytes to move
+ * @return number of bytes moved, 0 at the end of the stream, -1 on failure
+ */
+ssize_t http_splice(int from, int to, int pipefd[2], size_t max);
+
+#endif // HTTP_RESPONSE_H_
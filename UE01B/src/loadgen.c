@@ -0,0 +1,397 @@
+/**
+ * @file loadgen.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief A load generator for benchmarking HTTP servers
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "loadgen.h"
+
+/** @brief state of a benchmark run */
+typedef struct lg_run {
+    int epfd;                   /** epoll instance watching all connections */
+    struct addrinfo* ai;        /** address of the server */
+    char request[1024];         /** the request sent over and over */
+    size_t request_len;         /** length of request */
+    int keep_alive;             /** reuse connections */
+    long requests;              /** total number of requests */
+    long issued;                /** number of requests started */
+    long completed;             /** number of successful responses */
+    long failed;                /** number of failed requests */
+    long long bytes;            /** received bytes (header and body) */
+    int open;                   /** number of open connections */
+    lg_histogram hist;          /** latencies of the successful requests */
+} lg_run;
+
+/** @brief returns the current time in nanoseconds */
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** @brief returns the histogram bucket of a latency */
+static int hist_bucket(double ns) {
+    unsigned long long v = ns > 0 ? (unsigned long long)ns : 0;
+    if (v < LG_SUB_BUCKETS) return v;
+
+    int e = 63 - __builtin_clzll(v);
+    int b = (e - 3) * LG_SUB_BUCKETS + (int)((v >> (e - 4)) & (LG_SUB_BUCKETS - 1));
+    return b < LG_BUCKETS ? b : LG_BUCKETS - 1;
+}
+
+/** @brief returns the smallest latency (ns) falling into a bucket */
+static double hist_lower(int b) {
+    if (b < LG_SUB_BUCKETS) return b;
+    int e = b / LG_SUB_BUCKETS + 3;
+    return (double)((unsigned long long)(LG_SUB_BUCKETS + b % LG_SUB_BUCKETS) << (e - 4));
+}
+
+/** @brief records the latency of a request */
+static void hist_record(lg_histogram* h, double ns) {
+    h->count[hist_bucket(ns)]++;
+    h->total++;
+    if (ns > h->max) h->max = ns;
+}
+
+/**
+ * @brief Returns a percentile of the recorded latencies
+ *
+ * @param h the histogram
+ * @param p the percentile (0 < p <= 100)
+ * @return the upper bound of the bucket containing the percentile (ns)
+ */
+static double hist_percentile(lg_histogram* h, double p) {
+    long long rank = (long long)(h->total * p / 100.0 + 0.5), seen = 0;
+    if (rank < 1) rank = 1;
+    for (int b = 0; b < LG_BUCKETS; b++) {
+        seen += h->count[b];
+        if (seen >= rank) {
+            double upper = b + 1 < LG_BUCKETS ? hist_lower(b + 1) : h->max;
+            return upper < h->max ? upper : h->max;
+        }
+    }
+    return h->max;
+}
+
+/** @brief closes a connection */
+static void lg_close(lg_run* run, lg_conn* c) {
+    if (c->fd < 0) return;
+    close(c->fd);
+    c->fd = -1;
+    run->open--;
+}
+
+/**
+ * @brief Starts the next request on a connection
+ * @details Opens a new connection, if the old one can't be reused.
+ *
+ * @param run the benchmark run
+ * @param c the connection
+ * @return 0 on success, -1 if the connection couldn't be opened
+ */
+static int lg_start(lg_run* run, lg_conn* c) {
+    struct epoll_event ev;
+    ev.data.ptr = c;
+    c->start = now_ns();
+    c->sent = 0;
+    c->len = 0;
+    c->header_done = 0;
+    c->body_left = -1;
+    c->bytes = 0;
+    run->issued++;
+
+    if (c->fd >= 0 && c->keep_alive) {
+        c->state = LG_SENDING;
+        ev.events = EPOLLOUT;
+        return epoll_ctl(run->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+    }
+
+    lg_close(run, c);
+    c->fd = socket(run->ai->ai_family, run->ai->ai_socktype | SOCK_NONBLOCK, run->ai->ai_protocol);
+    if (c->fd < 0) return -1;
+    run->open++;
+    if (connect(c->fd, run->ai->ai_addr, run->ai->ai_addrlen) < 0 && errno != EINPROGRESS) {
+        lg_close(run, c);
+        return -1;
+    }
+
+    c->state = LG_CONNECTING;
+    ev.events = EPOLLOUT;
+    if (epoll_ctl(run->epfd, EPOLL_CTL_ADD, c->fd, &ev) < 0) {
+        lg_close(run, c);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Continues with the next request or closes the connection if all requests have been started
+ *
+ * @param run the benchmark run
+ * @param c the connection
+ */
+static void lg_next(lg_run* run, lg_conn* c) {
+    while (run->issued < run->requests) {
+        if (lg_start(run, c) == 0) return;
+        run->failed++;
+        lg_close(run, c);
+    }
+    lg_close(run, c);
+}
+
+/**
+ * @brief Parses the header of a response as soon as it is complete
+ *
+ * @param c the connection
+ * @return 1 if the header is complete, 0 if more bytes are needed, -1 on a protocol error
+ */
+static int lg_parse_header(lg_conn* c) {
+    char* end = NULL;
+    for (size_t i = 0; i + 3 < c->len; i++) {
+        if (memcmp(c->buf + i, "\r\n\r\n", 4) == 0) {
+            end = c->buf + i + 4;
+            break;
+        }
+    }
+    if (end == NULL) return c->len < LG_BUF_SIZE ? 0 : -1;
+
+    if (c->len < 12 || strncmp(c->buf, "HTTP/1.", 7) != 0 || c->buf[9] != '2') return -1;
+    c->keep_alive = strncmp(c->buf, "HTTP/1.1", 8) == 0;
+
+    /* search the headers for the length of the body and the connection state */
+    for (char* line = (char*)memchr(c->buf, '\n', end - c->buf) + 1; line < end - 2;) {
+        char* eol = memchr(line, '\n', end - line);
+        if (strncasecmp(line, "Content-Length:", 15) == 0)
+            c->body_left = strtoll(line + 15, NULL, 10);
+        else if (strncasecmp(line, "Connection:", 11) == 0) {
+            char* v = line + 11;
+            while (*v == ' ') v++;
+            if (strncasecmp(v, "close", 5) == 0) c->keep_alive = 0;
+            else if (strncasecmp(v, "keep-alive", 10) == 0) c->keep_alive = 1;
+        }
+        line = eol + 1;
+    }
+    if (c->body_left < 0) c->keep_alive = 0; // the body ends with the connection
+
+    c->header_done = 1;
+    size_t header_len = end - c->buf;
+    c->bytes = header_len;
+    if (c->body_left >= 0) c->body_left -= c->len - header_len;
+    c->bytes += c->len - header_len;
+    return 1;
+}
+
+/**
+ * @brief Records a completed response and continues with the next request
+ *
+ * @param run the benchmark run
+ * @param c the connection
+ */
+static void lg_complete(lg_run* run, lg_conn* c) {
+    hist_record(&run->hist, now_ns() - c->start);
+    run->completed++;
+    run->bytes += c->bytes;
+    if (!c->keep_alive || !run->keep_alive) lg_close(run, c);
+    lg_next(run, c);
+}
+
+/**
+ * @brief Records a failed request and continues with the next request on a new connection
+ *
+ * @param run the benchmark run
+ * @param c the connection
+ */
+static void lg_fail(lg_run* run, lg_conn* c) {
+    run->failed++;
+    lg_close(run, c);
+    lg_next(run, c);
+}
+
+/**
+ * @brief Advances the state of a connection after epoll reported an event
+ *
+ * @param run the benchmark run
+ * @param c the connection
+ */
+static void lg_event(lg_run* run, lg_conn* c) {
+    if (c->fd < 0) return; // closed while handling an earlier event of the same batch
+
+    if (c->state == LG_CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        struct sockaddr_storage peer;
+        socklen_t peer_len = sizeof(peer);
+        if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+            lg_fail(run, c);
+            return;
+        }
+        /* the event may belong to the previous socket of this connection */
+        if (getpeername(c->fd, (struct sockaddr*)&peer, &peer_len) < 0) return;
+        c->state = LG_SENDING;
+    }
+
+    if (c->state == LG_SENDING) {
+        ssize_t n = send(c->fd, run->request + c->sent, run->request_len - c->sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) lg_fail(run, c);
+            return;
+        }
+        c->sent += n;
+        if (c->sent < run->request_len) return;
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (epoll_ctl(run->epfd, EPOLL_CTL_MOD, c->fd, &ev) < 0) lg_fail(run, c);
+        else c->state = LG_RECEIVING;
+        return;
+    }
+
+    for (;;) {
+        char body[LG_BUF_SIZE];
+        ssize_t n;
+        if (c->header_done) n = read(c->fd, body, sizeof(body));
+        else n = read(c->fd, c->buf + c->len, LG_BUF_SIZE - c->len);
+
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) lg_fail(run, c);
+            return;
+        }
+        if (n == 0) {
+            /* the server closed the connection, fine if the body ends with it */
+            if (c->header_done && c->body_left < 0) lg_complete(run, c);
+            else lg_fail(run, c);
+            return;
+        }
+
+        if (c->header_done) {
+            c->bytes += n;
+            if (c->body_left >= 0) c->body_left -= n;
+        } else {
+            c->len += n;
+            int res = lg_parse_header(c);
+            if (res < 0) {
+                lg_fail(run, c);
+                return;
+            }
+        }
+
+        if (c->header_done && c->body_left == 0) {
+            lg_complete(run, c);
+            return;
+        }
+        if (c->header_done && c->body_left < -1) { // more bytes than announced
+            lg_fail(run, c);
+            return;
+        }
+    }
+}
+
+/** @brief prints the results of a benchmark run */
+static void lg_report(lg_run* run, double elapsed) {
+    lg_histogram* h = &run->hist;
+    double s = elapsed / 1e9;
+
+    printf("Requests:     %li completed, %li failed\n", run->completed, run->failed);
+    printf("Time:         %.3f s\n", s);
+    printf("Throughput:   %.1f requests/s\n", run->completed / s);
+    printf("Transfer:     %.2f MB/s (%lli bytes)\n", run->bytes / s / 1e6, run->bytes);
+    if (h->total == 0) return;
+
+    printf("Latency:      p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms\n",
+        hist_percentile(h, 50) / 1e6, hist_percentile(h, 90) / 1e6, hist_percentile(h, 99) / 1e6,
+        hist_percentile(h, 99.9) / 1e6, h->max / 1e6);
+
+    /* one line per power of two */
+    long long peak = 0, rows[LG_BUCKETS / LG_SUB_BUCKETS] = {0};
+    for (int b = 0; b < LG_BUCKETS; b++) {
+        rows[b / LG_SUB_BUCKETS] += h->count[b];
+        if (rows[b / LG_SUB_BUCKETS] > peak) peak = rows[b / LG_SUB_BUCKETS];
+    }
+    printf("Histogram:\n");
+    for (int r = 0; r < LG_BUCKETS / LG_SUB_BUCKETS; r++) {
+        if (rows[r] == 0) continue;
+        int width = (int)(rows[r] * 50 / peak);
+        printf("  %10.3f ms - %10.3f ms | %-50.*s %lli\n", hist_lower(r * LG_SUB_BUCKETS) / 1e6,
+            hist_lower((r + 1) * LG_SUB_BUCKETS) / 1e6, width > 0 ? width : 1,
+            "##################################################", rows[r]);
+    }
+}
+
+int loadgen(char* host, char* port, char* file, long requests, int concurrency, int keep_alive) {
+    lg_run* run = calloc(1, sizeof(lg_run));
+    if (run == NULL) return EXIT_FAILURE;
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof hints);
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    int res = getaddrinfo(host, port, &hints, &run->ai);
+    if (res != 0) {
+        fprintf(stderr, "Failed to get addrinfo: %s\n", gai_strerror(res));
+        free(run);
+        return EXIT_FAILURE;
+    }
+
+    run->request_len = snprintf(run->request, sizeof(run->request),
+        "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: %s\r\n\r\n", file, host, keep_alive ? "keep-alive" : "close");
+    run->keep_alive = keep_alive;
+    run->requests = requests;
+    if (concurrency > requests) concurrency = requests;
+
+    lg_conn* conns = calloc(concurrency, sizeof(lg_conn));
+    run->epfd = epoll_create1(0);
+    if (conns == NULL || run->epfd < 0) {
+        fprintf(stderr, "Failed to set up connections: %s\n", strerror(errno));
+        freeaddrinfo(run->ai);
+        free(conns);
+        free(run);
+        return EXIT_FAILURE;
+    }
+
+    double start = now_ns();
+    for (int i = 0; i < concurrency; i++) {
+        conns[i].fd = -1;
+        lg_next(run, &conns[i]);
+    }
+
+    struct epoll_event events[256];
+    while (run->open > 0) {
+        int n = epoll_wait(run->epfd, events, 256, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Failed to wait for events: %s\n", strerror(errno));
+            break;
+        }
+        for (int i = 0; i < n; i++) lg_event(run, events[i].data.ptr);
+    }
+    double elapsed = now_ns() - start;
+
+    lg_report(run, elapsed);
+    res = run->failed == 0 && run->completed == requests ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    for (int i = 0; i < concurrency; i++) lg_close(run, &conns[i]);
+    close(run->epfd);
+    freeaddrinfo(run->ai);
+    free(conns);
+    free(run);
+    return res;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file loadgen.h
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief A load generator for benchmarking HTTP servers
+ * @details Sends a fixed number of GET requests over a number of concurrent
+ * connections from a single thread with non-blocking sockets and epoll, and
+ * reports throughput and latency percentiles.
+ */
+#ifndef LOADGEN_H_   /* Include guard */
+#define LOADGEN_H_
+
+#define LG_BUF_SIZE 16384       // receive buffer of a connection
+#define LG_SUB_BUCKETS 16       // linear sub-buckets per power of two of the latency histogram
+#define LG_BUCKETS (40 * LG_SUB_BUCKETS) // covers latencies up to 2^40 ns
+
+/** @brief the phases a connection of the load generator goes through */
+typedef enum lg_state {
+    LG_CONNECTING,  /** waiting for the TCP handshake */
+    LG_SENDING,     /** sending the request */
+    LG_RECEIVING    /** receiving the response */
+} lg_state;
+
+/** @brief a connection of the load generator */
+typedef struct lg_conn {
+    int fd;                     /** socket, -1 if the connection is closed */
+    lg_state state;             /** current phase */
+    size_t sent;                /** bytes of the request allready sent */
+    char buf[LG_BUF_SIZE];      /** received bytes of the response header */
+    size_t len;                 /** number of bytes in buf */
+    int header_done;            /** set once the header of the response has been received */
+    long long body_left;        /** bytes of the body still to be received, -1 if it ends with the connection */
+    long long bytes;            /** bytes of the current response received so far */
+    int keep_alive;             /** the connection can be reused for the next request */
+    double start;               /** time the current request was started (ns) */
+} lg_conn;
+
+/** @brief latency histogram with logarithmic buckets */
+typedef struct lg_histogram {
+    long long count[LG_BUCKETS];    /** number of requests per bucket */
+    long long total;                /** number of recorded requests */
+    double max;                     /** highest recorded latency (ns) */
+} lg_histogram;
+
+/**
+ * @brief Runs the benchmark and prints the results to stdout
+ *
+ * @param host the host to connect to
+ * @param port the port to connect to
+ * @param file the requested path
+ * @param requests total number of requests to send
+ * @param concurrency number of concurrent connections
+ * @param keep_alive if set, connections are reused for multiple requests
+ * @return EXIT_SUCCESS if all requests succeeded
+ */
+int loadgen(char* host, char* port, char* file, long requests, int concurrency, int keep_alive);
+
+#endif // LOADGEN_H_
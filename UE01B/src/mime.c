@@ -0,0 +1,55 @@
+/**
+ * @file mime.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Content types of the served files
+ */
+
+#include <string.h>
+#include <strings.h>
+
+#include "mime.h"
+
+/** @brief known extensions, text formats are compressed, images, archives and media are not */
+static const mime_type types[] = {
+    { "html",   "text/html; charset=utf-8",         1 },
+    { "htm",    "text/html; charset=utf-8",         1 },
+    { "css",    "text/css; charset=utf-8",          1 },
+    { "js",     "application/javascript",           1 },
+    { "mjs",    "application/javascript",           1 },
+    { "json",   "application/json",                 1 },
+    { "xml",    "application/xml",                  1 },
+    { "txt",    "text/plain; charset=utf-8",        1 },
+    { "md",     "text/markdown; charset=utf-8",     1 },
+    { "csv",    "text/csv; charset=utf-8",          1 },
+    { "svg",    "image/svg+xml",                    1 },
+    { "ico",    "image/x-icon",                     1 },
+    { "wasm",   "application/wasm",                 1 },
+    { "pdf",    "application/pdf",                  0 },
+    { "png",    "image/png",                        0 },
+    { "jpg",    "image/jpeg",                       0 },
+    { "jpeg",   "image/jpeg",                       0 },
+    { "gif",    "image/gif",                        0 },
+    { "webp",   "image/webp",                       0 },
+    { "woff",   "font/woff",                        0 },
+    { "woff2",  "font/woff2",                       0 },
+    { "mp3",    "audio/mpeg",                       0 },
+    { "mp4",    "video/mp4",                        0 },
+    { "webm",   "video/webm",                       0 },
+    { "zip",    "application/zip",                  0 },
+    { "gz",     "application/gzip",                 0 },
+    { "tgz",    "application/gzip",                 0 },
+};
+
+/** @brief type of files with an unknown extension */
+static const mime_type unknown = { "", "application/octet-stream", 0 };
+
+const mime_type* mime_lookup(const char* path) {
+    const char* dot = strrchr(path, '.');
+    if (dot == NULL || strchr(dot, '/') != NULL) return &unknown;
+
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+        if (strcasecmp(dot + 1, types[i].ext) == 0) return &types[i];
+    return &unknown;
+}
@@ -0,0 +1,29 @@
+/**
+ * @file mime.h
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Content types of the served files
+ * @details The type of a file is derived from its extension. Besides the
+ * value of the Content-Type header, the table tells whether compressing
+ * files of that type is worthwhile.
+ */
+#ifndef MIME_H_   /* Include guard */
+#define MIME_H_
+
+/** @brief a content type */
+typedef struct mime_type {
+    const char* ext;        /** file extension without the dot */
+    const char* type;       /** value of the Content-Type header */
+    int compress;           /** files of this type compress well */
+} mime_type;
+
+/**
+ * @brief Returns the content type of a file
+ *
+ * @param path path of the file
+ * @return the type, application/octet-stream if the extension is unknown
+ */
+const mime_type* mime_lookup(const char* path);
+
+#endif // MIME_H_
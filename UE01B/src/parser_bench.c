@@ -0,0 +1,214 @@
+/**
+ * @file parser_bench.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Fuzzer and benchmark for the HTTP request parser
+ * @details The fuzzer mutates sample requests and checks, that feeding them
+ * to the parser in random pieces gives the same result as parsing them at
+ * once. The benchmark measures the time needed to parse a typical request.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "http_parser.h"
+
+static char* pname;
+
+/** @brief requests the fuzzer starts from */
+static const char* samples[] = {
+    "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n",
+    "GET /index.html HTTP/1.0\r\n\r\n",
+    "GET /a/b/c.txt?x=1 HTTP/1.1\r\nHost: example.org\r\nConnection: keep-alive\r\n"
+        "Accept: */*\r\nRange: bytes=0-99\r\n\r\n",
+    "GET / HTTP/1.1\nHost: x\nConnection:close\n\n",
+    "\r\nGET /x HTTP/1.1\r\nX-Empty:\r\nX-Tab:\tvalue\t \r\n\r\nGET /next HTTP/1.1\r\n\r\n",
+};
+
+/** @brief a request as sent by a browser, used by the benchmark */
+static const char* bench_request =
+    "GET /wp-content/uploads/2019/10/header-image.jpg HTTP/1.1\r\n"
+    "Host: www.example.org\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:70.0) Gecko/20100101 Firefox/70.0\r\n"
+    "Accept: image/webp,*/*\r\n"
+    "Accept-Language: de,en-US;q=0.7,en;q=0.3\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Connection: keep-alive\r\n"
+    "Referer: https://www.example.org/\r\n"
+    "Cookie: session=0123456789abcdef0123456789abcdef\r\n"
+    "If-Modified-Since: Thu, 31 Oct 2019 10:00:00 GMT\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "\r\n";
+
+/**
+ * @brief Prints the correct usage of the Programm
+ */
+static void usage(void) {
+    fprintf(stderr, "Usage: %s [-f ROUNDS] [-n REQUESTS]\n"
+        "\t-f number of fuzzing rounds (default = 100000)\n"
+        "\t-n number of requests parsed by the benchmark (default = 1000000)\n", pname);
+    exit(EXIT_FAILURE);
+}
+
+/** @brief compares two slices by their offset in the buffer */
+static int slice_differs(http_slice a, const char* abuf, http_slice b, const char* bbuf) {
+    return a.len != b.len || a.ptr - abuf != b.ptr - bbuf;
+}
+
+/** @brief compares the results of two parsed requests */
+static int requests_differ(http_request* a, const char* abuf, http_request* b, const char* bbuf) {
+    if (a->length != b->length || a->header_count != b->header_count) return 1;
+    if (slice_differs(a->method, abuf, b->method, bbuf) || slice_differs(a->path, abuf, b->path, bbuf) ||
+        slice_differs(a->version, abuf, b->version, bbuf))
+        return 1;
+    for (int i = 0; i < a->header_count; i++)
+        if (slice_differs(a->headers[i].name, abuf, b->headers[i].name, bbuf) ||
+            slice_differs(a->headers[i].value, abuf, b->headers[i].value, bbuf))
+            return 1;
+    return 0;
+}
+
+/**
+ * @brief Mutates a request at random
+ *
+ * @param buf the request, has to have room for 16 more bytes
+ * @param len length of the request
+ * @return the new length
+ */
+static size_t mutate(char* buf, size_t len) {
+    static const char special[] = "\r\n :\t\x7f\0/";
+    int n = 1 + rand() % 4;
+    while (n--) {
+        size_t pos = len ? rand() % len : 0;
+        switch (rand() % 4) {
+        case 0: // replace a byte
+            if (len) buf[pos] = rand() % 2 ? special[rand() % (sizeof(special) - 1)] : rand();
+            break;
+        case 1: // insert a byte
+            memmove(buf + pos + 1, buf + pos, len - pos);
+            buf[pos] = special[rand() % (sizeof(special) - 1)];
+            len++;
+            break;
+        case 2: // remove a byte
+            if (len) {
+                memmove(buf + pos, buf + pos + 1, len - pos - 1);
+                len--;
+            }
+            break;
+        default: // truncate
+            len = pos;
+            break;
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief Parses mutated requests at once and in random pieces and compares the results
+ *
+ * @param rounds number of requests to check
+ * @return number of requests, for which the results differed
+ */
+static long fuzz(long rounds) {
+    char buf[1024];
+    long failures = 0, done = 0, errors = 0;
+
+    for (long i = 0; i < rounds; i++) {
+        const char* sample = samples[rand() % (sizeof(samples) / sizeof(samples[0]))];
+        size_t len = strlen(sample);
+        memcpy(buf, sample, len);
+        len = mutate(buf, len);
+
+        http_request whole, pieces;
+        http_parser_init(&whole);
+        int res_whole = http_parse_request(&whole, buf, len);
+
+        int res_pieces = HTTP_PARSE_AGAIN;
+        http_parser_init(&pieces);
+        for (size_t avail = 0; avail < len && res_pieces == HTTP_PARSE_AGAIN;) {
+            avail += 1 + rand() % 8;
+            if (avail > len) avail = len;
+            res_pieces = http_parse_request(&pieces, buf, avail);
+        }
+        if (len == 0) res_pieces = http_parse_request(&pieces, buf, 0);
+
+        if (res_whole != res_pieces ||
+            (res_whole == HTTP_PARSE_DONE && requests_differ(&whole, buf, &pieces, buf))) {
+            fprintf(stderr, "%s: Results differ for request: %.*s\n", pname, (int)len, buf);
+            failures++;
+        }
+        if (res_whole == HTTP_PARSE_DONE) done++;
+        if (res_whole == HTTP_PARSE_ERROR) errors++;
+    }
+
+    printf("fuzz: %li requests, %li complete, %li malformed, %li failures\n", rounds, done, errors, failures);
+    return failures;
+}
+
+/** @brief returns the current time in nanoseconds */
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Measures the time needed to parse a typical request
+ *
+ * @param requests number of requests to parse
+ * @param pieces number of pieces the request is split into
+ */
+static void bench(long requests, size_t pieces) {
+    size_t len = strlen(bench_request);
+    long headers = 0;
+    http_request r;
+
+    double start = now_ns();
+    for (long i = 0; i < requests; i++) {
+        http_parser_init(&r);
+        for (size_t p = 1; p <= pieces; p++)
+            http_parse_request(&r, bench_request, len * p / pieces);
+        headers += r.header_count;
+    }
+    double ns = (now_ns() - start) / requests;
+
+    printf("bench: %zu bytes in %zu piece(s), %i headers: %.1f ns/request, %.0f MB/s\n",
+        len, pieces, (int)(headers / requests), ns, len / ns * 1e3);
+}
+
+/**
+ * Program entry point.
+ *
+ * @return EXIT_SUCCESS if the fuzzer found no differences
+ */
+int main(int argc, char *argv[]) {
+    pname = argv[0];
+    long rounds = 100000, requests = 1000000;
+    int c;
+
+    while ((c = getopt(argc, argv, "f:n:")) != -1) {
+        switch (c) {
+            case 'f':
+                rounds = strtol(optarg, NULL, 10);
+                break;
+            case 'n':
+                requests = strtol(optarg, NULL, 10);
+                break;
+            case '?':
+            default:
+                usage();
+        }
+    }
+    if (rounds < 0 || requests < 1) usage();
+
+    srand(time(NULL));
+    long failures = fuzz(rounds);
+    bench(requests, 1);
+    bench(requests, 4);
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
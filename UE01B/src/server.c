@@ -4,126 +4,1103 @@
  * @date 31.10.2019
  *
  * @brief A simple HTTP Server
- * @details Creates an HTTP Server which handles GET request. 
+ * @details Creates an HTTP Server which handles GET request.
  * The documentroot has to be passed.
  * The default file to be transmitted when a folder is requested is called
  * indexfile and can be specified with the -i argument (default: index.html).
  * The Port to bind to can be specified with -p (default: 8080)
+ * The connections are served by one or more worker threads (-w) with
+ * non-blocking sockets and epoll, every connection keeps its own state
+ * (see struct connection). Every worker binds its own listening socket with
+ * SO_REUSEPORT, so the kernel distributes new connections among them.
+ * Connections are kept alive between requests (HTTP/1.1 persistent
+ * connections) and pipelined requests are answered in order.
+ * Every worker counts its requests and the time spent in the phases of a
+ * request (see stats.h), the sum of all workers is served as the stats page.
+ * Requests are logged by the asynchronous access log (see accesslog.h).
  */
 
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <netdb.h>
+#include <poll.h>
 #include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <time.h>
 #include <unistd.h>
+#include <zlib.h>
 
+#include "mime.h"
 #include "server.h"
 
-#define MAX_CONNECTIONS 10
+#define LISTEN_BACKLOG SOMAXCONN
 #define RFC822 "%a, %d %b %Y %H:%M:%S GMT"
 
+/* user_data of the io_uring operations, which don't belong to a connection */
+#define URING_ACCEPT 1
+#define URING_QUIT 2
+#define URING_CANCEL 3
+
 volatile sig_atomic_t quit = 0;
 
 static char* pname;
+static int quit_fd = -1; /** eventfd, which becomes readable for all workers when quit is set */
+static worker* all_workers; /** the workers, whose stats are summed up for the stats page */
+static int worker_count;    /** number of entries in all_workers */
+
+static time_t parse_http_date(http_slice s);
+static int accepts_gzip(http_slice list);
+static void send_stats(connection* c, http_slice query);
 
 /**
- * @details Sets global variable 'quit' to 1 so the programm can safely close after all connections have been served
- * 
+ * @details Sets global variable 'quit' to 1 so the programm can safely close after all connections have been served.
+ * All workers are woken up by signaling quit_fd.
+ *
  * @param signal the singal beeing handeled
  */
 void handle_soft_exit(int signal) {
+    uint64_t one = 1;
+    int saved_errno = errno;
     quit = 1;
+    if (quit_fd >= 0 && write(quit_fd, &one, sizeof(one)) < 0) {
+        /* the eventfd is only used to wake up the workers, a full counter doesn't matter */
+    }
+    errno = saved_errno;
 }
 
 /**
  * @brief Prints the correct usage of the Programm
- * 
+ *
  * @param pname the programmname (argv[0])
  * @return always returns EXIT_FAILURE
  */
 static void usage(char* pname) {
-	fprintf(stderr, "Usage: %s [-p PORT] [-i INDEX] DOC_ROOT\n"
+	fprintf(stderr, "Usage: %s [-p PORT] [-i INDEX] [-w WORKERS] [-u] [-s STATS_PATH] [-l LOGFILE | -q] DOC_ROOT\n"
     "\t-p PORT to bind to (default = 8080)\n"
-    "\t-i filename of file, which is transmitted when a folder is requested\n", pname);
+    "\t-i filename of file, which is transmitted when a folder is requested\n"
+    "\t-w number of worker threads serving connections (default = 1)\n"
+    "\t-u serve connections with io_uring instead of epoll (falls back to epoll if unavailable)\n"
+    "\t-s path the stats page is served at, append ?format=prometheus for the Prometheus format (default = /__stats)\n"
+    "\t-l file the access log is appended to (default = stdout)\n"
+    "\t-q disables the access log\n", pname);
 	exit(EXIT_FAILURE);
 }
 
+/**
+ * @brief Puts a filedescriptor into non-blocking mode
+ *
+ * @param fd the filedescriptor
+ * @return 0 on success, -1 on error
+ */
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
 
 /**
- * @brief Handles a singular Connection beteen the server and a client
- * 
- * @param sockfile pointer to the socket
- * @param documentroot the servers root folder in respect to the html documents (conventionally /var/www)
- * @return returns EXIT_SUCCESS if connection was handeled sucessfully
+ * @brief Allocates the state for a newly accepted connection and adds it to the list of connections
+ *
+ * @param w the worker serving the connection
+ * @param connfd the socket of the connection
+ * @param peer the address of the client
+ * @return the new connection or NULL if no memory is available
+ */
+static connection* open_connection(worker* w, int connfd, const struct sockaddr_in* peer) {
+    connection* c = malloc(sizeof(connection));
+    if (c == NULL) return NULL;
+
+    c->fd = connfd;
+    c->peer = *peer;
+    c->state = CONN_READ;
+    c->w = w;
+    c->req_len = 0;
+    c->req_used = 0;
+    c->requests = 0;
+    c->keep_alive = 0;
+    c->events = EPOLLIN;
+    c->last_active = time(NULL);
+    http_parser_init(&c->parser);
+    c->out_len = 0;
+    c->iovcnt = 0;
+    c->iov_idx = 0;
+    c->entry = NULL;
+    c->body = NULL;
+    c->sent = 0;
+    c->op = OP_NONE;
+    c->closing = 0;
+    c->file = NULL;
+    c->file_fd = -1;
+    c->file_off = 0;
+    c->file_len = 0;
+    c->pipefd[0] = -1;
+    c->pipefd[1] = -1;
+    c->piped = 0;
+
+    c->prev = NULL;
+    c->next = w->connections;
+    if (w->connections) w->connections->prev = c;
+    else w->idlest = c;
+    w->connections = c;
+    return c;
+}
+
+/**
+ * @brief Marks a connection as active by moving it to the front of the list of connections
+ * @details This keeps the list sorted by the time of the last activity, so idle
+ * connections can be found at the end of the list.
+ *
+ * @param w the worker serving the connection
+ * @param c the connection
+ */
+static void touch_connection(worker* w, connection* c) {
+    c->last_active = time(NULL);
+    if (c->prev == NULL) return;
+
+    c->prev->next = c->next;
+    if (c->next) c->next->prev = c->prev;
+    else w->idlest = c->prev;
+
+    c->prev = NULL;
+    c->next = w->connections;
+    w->connections->prev = c;
+    w->connections = c;
+}
+
+/**
+ * @brief Closes the socket and the file of a connection and frees its state
+ *
+ * @param w the worker serving the connection
+ * @param c the connection
+ */
+static void close_connection(worker* w, connection* c) {
+    if (c->prev) c->prev->next = c->next;
+    else w->connections = c->next;
+    if (c->next) c->next->prev = c->prev;
+    else w->idlest = c->prev;
+
+    if (c->entry) cache_release(c->entry);
+    if (c->file) fdcache_release(c->file);
+    if (c->pipefd[0] >= 0) {
+        close(c->pipefd[0]);
+        close(c->pipefd[1]);
+    }
+    close(c->fd); // also removes the socket from the epoll set
+    free(c->body);
+    free(c);
+    STATS_ADD(w->stats.closed, 1);
+}
+
+/**
+ * @brief Prepares a kept alive connection for its next request
+ * @details Frees the resources of the last response and moves pipelined
+ * requests, which have allready been received, to the front of the buffer.
+ *
+ * @param c the connection
+ */
+static void next_request(connection* c) {
+    if (c->entry) cache_release(c->entry);
+    if (c->file) fdcache_release(c->file);
+    free(c->body);
+    c->entry = NULL;
+    c->body = NULL;
+    c->file = NULL;
+    c->file_fd = -1;
+    c->sent = 0;
+    c->iovcnt = 0;
+    c->iov_idx = 0;
+
+    c->req_len -= c->req_used;
+    memmove(c->req, c->req + c->req_used, c->req_len);
+    c->req_used = 0;
+    http_parser_init(&c->parser);
+    c->state = CONN_READ;
+}
+
+/**
+ * @brief Reads the available bytes of a request into the buffer of the connection
+ *
+ * @param c the connection
+ * @return 1 if bytes were read or the buffer is full, 0 if no bytes are available
+ * and -1 if the connection was closed or failed
+ */
+static int read_request(connection* c) {
+    size_t space = REQ_BUF_SIZE - c->req_len;
+    if (space == 0) return 1;
+
+    ssize_t n = read(c->fd, c->req + c->req_len, space);
+    if (n < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+        return -1;
+    }
+    if (n == 0) return -1;
+
+    c->req_len += n;
+    return 1;
+}
+
+/**
+ * @brief Moves the file of a connection to the socket through a pipe with splice
+ * @details Used, if the file doesn't support sendfile. The file is spliced into
+ * the pipe of the connection and from there into the socket, so the data never
+ * has to be copied to userspace.
+ *
+ * @param c the connection
+ * @return the number of bytes sent to the socket or -1 on error (errno is set)
+ */
+static ssize_t splice_file(connection* c) {
+    if (c->pipefd[0] < 0 && pipe(c->pipefd) < 0) return -1;
+
+    if (c->file_off < c->file_len) {
+        ssize_t n = splice(c->file_fd, &c->file_off, c->pipefd[1], NULL,
+            c->file_len - c->file_off, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n < 0 && errno != EAGAIN) return -1;
+        if (n == 0) {
+            errno = EIO; // file was truncated
+            return -1;
+        }
+        if (n > 0) c->piped += n;
+    }
+
+    ssize_t n = splice(c->pipefd[0], NULL, c->fd, NULL, c->piped,
+        SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE);
+    if (n > 0) c->piped -= n;
+    return n;
+}
+
+/**
+ * @brief Marks n bytes of the pending output of a connection as sent
+ *
+ * @param c the connection
+ * @param n number of bytes sent
+ */
+static void advance_iov(connection* c, size_t n) {
+    while (c->iov_idx < c->iovcnt && n >= c->iov[c->iov_idx].iov_len)
+        n -= c->iov[c->iov_idx++].iov_len;
+    if (n > 0) {
+        c->iov[c->iov_idx].iov_base = (char*)c->iov[c->iov_idx].iov_base + n;
+        c->iov[c->iov_idx].iov_len -= n;
+    }
+}
+
+/**
+ * @brief Sends the pending output and the file of a connection without blocking
+ * @details The pending output is sent with a single gathering write, the file
+ * is transmitted with sendfile directly from the page cache, if the file
+ * doesn't support that, splice is used instead.
+ *
+ * @param c the connection
+ * @return 1 if the response has been sent completely, 0 if the socket is full
+ * and -1 if an error occured
  */
-int handle_connection(FILE* sockfile, char* documentroot, char* indexfile) {
-    char *buf = NULL;
-    size_t len = 0;
+static int flush_connection(connection* c) {
+    for (;;) {
+        ssize_t n;
+        int more = c->file_fd >= 0 && c->file_off < c->file_len;
 
-    /* fetch first line in request */
-    if (!getline(&buf, &len, sockfile)) return EXIT_FAILURE; 
-    fprintf(stdout, "%s: Request: %s", pname, buf);
-    
-    /* extract method, path and protocoll from request */
-    char* method = strtok(buf, " ");
-    char* path = strtok(NULL, " ");
-    char* protocol = strtok(NULL, "\r");
+        if (c->iov_idx < c->iovcnt) {
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = c->iov + c->iov_idx;
+            msg.msg_iovlen = c->iovcnt - c->iov_idx;
+            n = sendmsg(c->fd, &msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+            if (n >= 0) advance_iov(c, n);
+        } else if (c->pipefd[0] >= 0 && (more || c->piped > 0)) {
+            n = splice_file(c);
+        } else if (more) {
+            n = sendfile(c->fd, c->file_fd, &c->file_off, c->file_len - c->file_off);
+            if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                n = splice_file(c);
+            } else if (n == 0) {
+                errno = EIO; // file was truncated
+                n = -1;
+            }
+        } else {
+            return 1;
+        }
 
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            return -1;
+        }
+        c->sent += n;
+    }
+}
+
+/**
+ * @brief Builds the normalized path of a requested file
+ * @details Empty and "." segments are dropped and ".." removes the segment
+ * before it, so the path can't leave the documentroot and every file has a
+ * single path, which is used as key of the caches. Paths ending with a
+ * directory get the indexfile appended.
+ *
+ * @param out the buffer for the path
+ * @param size size of out
+ * @param root the documentroot
+ * @param path the requested path without the query
+ * @param indexfile the file sent when a directory is requested
+ * @return 0 on success, -1 if the path doesn't fit into out
+ */
+static int resolve_path(char* out, size_t size, const char* root, http_slice path, const char* indexfile) {
+    size_t rootlen = strlen(root), len = rootlen;
+    if (rootlen >= size) return -1;
+    memcpy(out, root, rootlen);
 
-    /* decline request if the three parameters couldn't be extracted */
-    if (!method||!path||!protocol) {
-        fprintf(stderr, "%s: Bad Request\n", pname);
-        send_error(sockfile, 400, "Bad Request");
+    const char *p = path.ptr, *end = path.ptr + path.len;
+    int dir = 1; // the path ends with a directory
+    while (p < end) {
+        while (p < end && *p == '/') p++;
+        const char* seg = p;
+        while (p < end && *p != '/') p++;
+        size_t n = p - seg;
+        if (n == 0) break;
 
+        dir = p < end;
+        if (n == 1 && seg[0] == '.') {
+            dir = 1;
+        } else if (n == 2 && seg[0] == '.' && seg[1] == '.') {
+            while (len > rootlen && out[len - 1] != '/') len--;
+            if (len > rootlen) len--;
+            dir = 1;
+        } else {
+            if (len + 1 + n >= size) return -1;
+            out[len++] = '/';
+            memcpy(out + len, seg, n);
+            len += n;
+        }
+    }
+
+    if (dir) {
+        size_t n = strlen(indexfile);
+        if (len + 1 + n >= size) return -1;
+        out[len++] = '/';
+        memcpy(out + len, indexfile, n);
+        len += n;
+    }
+    out[len] = '\0';
+    return 0;
+}
+
+/**
+ * @brief Handles a singular request of a connection
+ * @details Parses the received bytes of the request and does nothing as long
+ * as the header is incomplete. As soon as it is complete, the response is
+ * prepared in the connection and its state is changed to CONN_WRITE. The
+ * connection is kept alive, unless the client asks to close it, uses HTTP/1.0
+ * without asking for keep-alive or has reached MAX_REQUESTS.
+ *
+ * @param w the worker serving the connection (holds documentroot and indexfile)
+ * @param c the connection with the received request
+ * @return returns EXIT_SUCCESS if connection was handeled sucessfully
+ */
+int handle_connection(worker* w, connection* c) {
+    char *documentroot = w->documentroot, *indexfile = w->indexfile;
+    http_request* r = &c->parser;
+
+    uint64_t start = stats_now();
+    int res = http_parse_request(r, c->req, c->req_len);
+    if (res == HTTP_PARSE_AGAIN && c->req_len < REQ_BUF_SIZE)
+        return EXIT_SUCCESS; // wait for the rest of the header
+    c->started = start;
+    c->parsed = stats_now();
+    stats_record(&w->stats, PHASE_PARSE, c->parsed - start);
+
+    /* decline request if it is malformed or doesn't fit into the buffer */
+    if (res != HTTP_PARSE_DONE) {
+        c->keep_alive = 0;
+        send_error(c, 400, "Bad Request");
         return EXIT_FAILURE;
     }
-    
-    if (strcmp(method, "GET")!=0) { /* decline request if method is not "GET" */
-        fprintf(stderr, "%s: Not Implemented\n", pname);
-        send_error(sockfile, 501, "Not Implemented");
+    c->req_used = r->length;
+    c->requests++;
+
+    /* HTTP/1.1 connections are persistent unless the client closes them */
+    c->keep_alive = http_slice_eq(r->version, "HTTP/1.1");
+    const http_slice* h;
+    if ((h = http_find_header(r, "Connection")) != NULL) {
+        if (http_slice_has_token(*h, "close")) c->keep_alive = 0;
+        else if (http_slice_has_token(*h, "keep-alive")) c->keep_alive = 1;
+    }
+    int body = http_find_header(r, "Transfer-Encoding") != NULL ||
+        ((h = http_find_header(r, "Content-Length")) != NULL && !http_slice_eq(*h, "0"));
+
+    h = http_find_header(r, "If-Modified-Since");
+    c->if_modified_since = h ? parse_http_date(*h) : -1;
+    c->if_none_match.len = c->range.len = c->if_range.len = 0;
+    if ((h = http_find_header(r, "If-None-Match")) != NULL) c->if_none_match = *h;
+    if ((h = http_find_header(r, "Range")) != NULL) c->range = *h;
+    if ((h = http_find_header(r, "If-Range")) != NULL) c->if_range = *h;
+    h = http_find_header(r, "Accept-Encoding");
+    c->gzip = h ? accepts_gzip(*h) : 0;
+
+    /* request bodies are ignored, so the next request couldn't be found */
+    if (body || c->requests >= MAX_REQUESTS) c->keep_alive = 0;
+
+    if (!http_slice_eq(r->method, "GET")) { /* decline request if method is not "GET" */
+        send_error(c, 501, "Not Implemented");
         return EXIT_FAILURE;
     }
 
+    /* the stats page is generated instead of being read from the documentroot */
+    http_slice path = r->path, query = { NULL, 0 };
+    const char* mark = memchr(path.ptr, '?', path.len);
+    if (mark) {
+        query.ptr = mark + 1;
+        query.len = path.len - (mark + 1 - path.ptr);
+        path.len = mark - path.ptr;
+    }
+    if (http_slice_eq(path, w->statspath)) {
+        send_stats(c, query);
+        return EXIT_SUCCESS;
+    }
+
     /* create document path from documentroot, the path from the request and the (optional) indexfile */
-    char *filepath = calloc(strlen(documentroot) +
-        strlen(path) + strlen(indexfile) + 1, sizeof(char));
-    strcpy(filepath, documentroot);
-    strcat(filepath, path);
-    if (filepath[strlen(filepath)-1]=='/')
-        strcat(filepath, indexfile);
-    
-    fprintf(stdout, "%s: Requested File: %s\n", pname, filepath);
-    
-    while (strlen(buf)>2) {
-        getline(&buf, &len, sockfile);
-    }
-    fprintf(stderr, "%s: Sending response\n", pname);
-
-    send_file(sockfile, filepath);
-    free(filepath);
+    char filepath[PATH_MAX];
+    if (resolve_path(filepath, sizeof(filepath), documentroot, path, indexfile) < 0) {
+        send_error(c, 414, "URI Too Long");
+        return EXIT_FAILURE;
+    }
+
+    send_file(c, filepath);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Accepts all pending connections of the listening socket and adds them to the epoll set
+ *
+ * @param w the worker owning the listening socket
+ */
+static void accept_connections(worker* w) {
+    int connfd;
+    struct sockaddr_in in_addr; //optional
+    socklen_t in_addr_len;
+    struct epoll_event ev;
+
+    for (;;) {
+        uint64_t start = stats_now();
+        in_addr_len = sizeof(struct sockaddr_in);
+        if ((connfd = accept(w->sockfd, (struct sockaddr *) &in_addr, &in_addr_len)) < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            fprintf(stderr, "%s: Failed to accept: %s\n", pname, strerror(errno));
+            if (errno != EMFILE && errno != ENFILE && errno != ENOBUFS && errno != ENOMEM)
+                handle_soft_exit(SIGTERM);
+            return;
+        }
+
+        connection* c;
+        if (set_nonblocking(connfd) < 0 || (c = open_connection(w, connfd, &in_addr)) == NULL) {
+            fprintf(stderr, "%s: Failed to set up connection: %s\n", pname, strerror(errno));
+            close(connfd);
+            continue;
+        }
+
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        STATS_ADD(w->stats.accepted, 1);
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, connfd, &ev) < 0) {
+            fprintf(stderr, "%s: Failed to watch connection: %s\n", pname, strerror(errno));
+            close_connection(w, c);
+            continue;
+        }
+        stats_record(&w->stats, PHASE_ACCEPT, stats_now() - start);
+    }
+}
+
+/**
+ * @brief Changes the events epoll watches a connection for
+ *
+ * @param w the worker serving the connection
+ * @param c the connection
+ * @param events EPOLLIN or EPOLLOUT
+ * @return 0 on success, -1 if the connection failed and has been closed
+ */
+static int watch_connection(worker* w, connection* c, uint32_t events) {
+    if (c->events == events) return 0;
+
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.ptr = c;
+    if (epoll_ctl(w->epfd, EPOLL_CTL_MOD, c->fd, &ev) < 0) {
+        close_connection(w, c);
+        return -1;
+    }
+    c->events = events;
+    return 0;
+}
+
+/**
+ * @brief Counts a response, which has been sent or has failed, and writes it to the access log
+ * @details The log uses the common log format, followed by the time the
+ * request took in seconds.
+ *
+ * @param w the worker serving the connection
+ * @param c the connection
+ */
+static void finish_request(worker* w, connection* c) {
+    uint64_t now = stats_now();
+    stats_record(&w->stats, PHASE_SEND, now - c->prepared);
+    stats_record(&w->stats, PHASE_TOTAL, now - c->started);
+    STATS_ADD(w->stats.requests, 1);
+    STATS_ADD(w->stats.bytes, c->sent);
+    if (c->status >= 100 && c->status < 600) STATS_ADD(w->stats.responses[c->status / 100], 1);
+
+    if (!accesslog_enabled()) return;
+    char addr[INET_ADDRSTRLEN];
+    http_request* r = &c->parser;
+    inet_ntop(AF_INET, &c->peer.sin_addr, addr, sizeof(addr));
+    if (c->status == 400) { // the request line of a malformed request is unknown
+        accesslog_printf(&w->log, "%s - - [%s] \"-\" %i %zu %.6f\n", addr, accesslog_date(&w->log),
+            c->status, c->sent, (now - c->started) / 1e9);
+    } else {
+        accesslog_printf(&w->log, "%s - - [%s] \"%.*s %.*s %.*s\" %i %zu %.6f\n", addr, accesslog_date(&w->log),
+            (int)r->method.len, r->method.ptr, (int)r->path.len, r->path.ptr,
+            (int)r->version.len, r->version.ptr, c->status, c->sent, (now - c->started) / 1e9);
+    }
+}
+
+/**
+ * @brief Advances the state machine of a connection after epoll reported an event
+ * @details In state CONN_READ the request is read and handled. Once the response
+ * is prepared it is sent directly. If the socket can't take the whole response,
+ * the connection waits for EPOLLOUT and continues sending with the next event.
+ * After the response the connection is either closed or serves the next
+ * (possibly allready received) request.
+ *
+ * @param w the worker serving the connection
+ * @param c the connection
+ */
+static void serve_connection(worker* w, connection* c) {
+    if (c->state == CONN_READ) {
+        int res = read_request(c);
+        if (res < 0) {
+            close_connection(w, c);
+            return;
+        }
+        if (res == 0) return;
+    }
+    touch_connection(w, c);
+
+    for (;;) {
+        if (c->state == CONN_READ) {
+            handle_connection(w, c);
+            if (c->state == CONN_READ) {
+                watch_connection(w, c, EPOLLIN);
+                return;
+            }
+            c->prepared = stats_now();
+            stats_record(&w->stats, PHASE_OPEN, c->prepared - c->parsed);
+        }
+
+        int res = flush_connection(c);
+        if (res == 0) {
+            /* socket is full, continue as soon as it is writeable again */
+            watch_connection(w, c, EPOLLOUT);
+            return;
+        }
+        finish_request(w, c);
+        if (res < 0 || !c->keep_alive || quit) {
+            close_connection(w, c);
+            return;
+        }
+        next_request(c);
+    }
+}
+
+/**
+ * @brief Stops a worker from accepting new connections after the quit flag has been set
+ * @details Closes the listening socket and all connections which haven't started
+ * a request yet. Connections with a request in flight are kept open, so they
+ * can be served to completion.
+ *
+ * @param w the worker
+ */
+static void stop_worker(worker* w) {
+    epoll_ctl(w->epfd, EPOLL_CTL_DEL, quit_fd, NULL);
+    close(w->sockfd);
+    w->sockfd = -1;
+
+    connection* next;
+    for (connection* c = w->connections; c; c = next) {
+        next = c->next;
+        if (c->state == CONN_READ && c->req_len == 0) close_connection(w, c);
+    }
+}
+
+/** @brief frees the file, the compression and the open file cache of a worker */
+static void destroy_caches(worker* w) {
+    cache_destroy(w->cache);
+    cache_destroy(w->gzcache);
+    fdcache_destroy(w->fdcache);
+}
+
+/**
+ * @brief Event loop of a worker using epoll
+ * @details Waits with epoll for new connections and for connections which can
+ * be read from or written to, and advances their state. Once the quit flag is
+ * set, the remaining requests are drained for at most DRAIN_TIMEOUT seconds.
+ * Once per second connections which have been idle for IDLE_TIMEOUT seconds are closed.
+ *
+ * @param w the worker
+ */
+static void epoll_loop(worker* w) {
+    struct epoll_event events[MAX_EVENTS];
+    time_t deadline = 0, now, swept = 0;
+
+    while (w->sockfd >= 0 || (w->connections && time(NULL) < deadline)) {
+        if (quit && w->sockfd >= 0) {
+            stop_worker(w);
+            deadline = time(NULL) + DRAIN_TIMEOUT;
+            continue;
+        }
+
+        /* the log lines must not wait in the batch while the worker sleeps */
+        if (w->connections == NULL) accesslog_flush(&w->log);
+
+        int n = epoll_wait(w->epfd, events, MAX_EVENTS, w->connections ? 1000 : -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "%s: Failed to wait for events: %s\n", pname, strerror(errno));
+            handle_soft_exit(SIGTERM);
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == &quit_fd) continue; // handled at the top of the loop
+            if (events[i].data.ptr == NULL) {
+                if (w->sockfd >= 0) accept_connections(w);
+            } else
+                serve_connection(w, events[i].data.ptr);
+        }
+
+        if ((now = time(NULL)) != swept) {
+            while (w->idlest && w->idlest->last_active + IDLE_TIMEOUT <= now)
+                close_connection(w, w->idlest);
+            accesslog_flush(&w->log);
+            swept = now;
+        }
+    }
+}
+
+/**
+ * @brief Queues the next io_uring operation of a connection
+ * @details Depending on its state, the connection receives the next request,
+ * sends the pending output with a single gathering send or moves the next
+ * part of the file through its pipe into the socket.
+ *
+ * @param w the worker serving the connection
+ * @param c the connection
+ * @return 1 if an operation has been queued, 0 if the response has been sent
+ * completely and -1 on failure
+ */
+static int uring_queue(worker* w, connection* c) {
+    int more = c->file_fd >= 0 && c->file_off < c->file_len;
+    int sending = c->state == CONN_WRITE && c->iov_idx < c->iovcnt;
+    if (c->state == CONN_WRITE && !sending && c->piped == 0) {
+        if (!more) return 0;
+        if (c->pipefd[0] < 0 && pipe(c->pipefd) < 0) return -1;
+    }
+
+    struct io_uring_sqe* sqe = uring_sqe(&w->ring, (uintptr_t)c);
+    if (sqe == NULL) return -1;
+
+    if (c->state == CONN_READ) {
+        uring_prep_recv(sqe, c->fd, c->req + c->req_len, REQ_BUF_SIZE - c->req_len);
+        c->op = OP_RECV;
+    } else if (sending) {
+        memset(&c->msg, 0, sizeof(c->msg));
+        c->msg.msg_iov = c->iov + c->iov_idx;
+        c->msg.msg_iovlen = c->iovcnt - c->iov_idx;
+        uring_prep_sendmsg(sqe, c->fd, &c->msg, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+        c->op = OP_SEND;
+    } else if (c->piped > 0) {
+        uring_prep_splice(sqe, c->pipefd[0], -1, c->fd, c->piped);
+        c->op = OP_SPLICE_OUT;
+    } else {
+        off_t len = c->file_len - c->file_off;
+        uring_prep_splice(sqe, c->file_fd, c->file_off, c->pipefd[1],
+            len < URING_SPLICE_MAX ? len : URING_SPLICE_MAX);
+        c->op = OP_SPLICE_IN;
+    }
+    return 1;
+}
+
+/**
+ * @brief Advances the state machine of a connection until it has to wait for an io_uring operation
+ * @details The counterpart of serve_connection: handles the received request,
+ * queues the operations sending the response and continues with the next
+ * (possibly allready received) request afterwards.
+ *
+ * @param w the worker serving the connection
+ * @param c the connection, which has no operation in flight
+ */
+static void uring_serve(worker* w, connection* c) {
+    for (;;) {
+        if (c->state == CONN_READ) {
+            handle_connection(w, c);
+            if (c->state == CONN_WRITE) {
+                c->prepared = stats_now();
+                stats_record(&w->stats, PHASE_OPEN, c->prepared - c->parsed);
+            }
+        }
+
+        int res = uring_queue(w, c);
+        if (res > 0) return;
+        if (res < 0) {
+            if (c->state == CONN_WRITE) finish_request(w, c);
+            close_connection(w, c);
+            return;
+        }
+
+        finish_request(w, c);
+        if (!c->keep_alive || quit) {
+            close_connection(w, c);
+            return;
+        }
+        next_request(c);
+    }
+}
+
+/**
+ * @brief Closes a connection, whose operation is still in flight
+ * @details The socket is shut down, so the operation completes right away,
+ * and the connection is closed with its completion.
+ *
+ * @param c the connection
+ */
+static void uring_close(connection* c) {
+    if (c->closing) return;
+    shutdown(c->fd, SHUT_RDWR);
+    c->closing = 1;
+}
+
+/**
+ * @brief Handles the completion of the operation of a connection
+ *
+ * @param w the worker serving the connection
+ * @param c the connection
+ * @param res the result of the operation (bytes transferred or a negative errno)
+ */
+static void uring_complete(worker* w, connection* c, int res) {
+    conn_op op = c->op;
+    c->op = OP_NONE;
+    if (c->closing) {
+        close_connection(w, c);
+        return;
+    }
+
+    if (res == -EAGAIN || res == -EINTR) {
+        /* nothing happened, the operation is simply queued again */
+    } else if (op == OP_RECV) {
+        if (res <= 0) {
+            close_connection(w, c);
+            return;
+        }
+        c->req_len += res;
+    } else if (res < 0 || (op == OP_SPLICE_IN && res == 0)) { // a file of 0 bytes has been truncated
+        finish_request(w, c);
+        close_connection(w, c);
+        return;
+    } else if (op == OP_SEND) {
+        advance_iov(c, res);
+        c->sent += res;
+    } else if (op == OP_SPLICE_IN) {
+        c->file_off += res;
+        c->piped += res;
+    } else {
+        c->piped -= res;
+        c->sent += res;
+    }
+
+    touch_connection(w, c);
+    uring_serve(w, c);
+}
+
+/**
+ * @brief Sets up a connection accepted by io_uring and starts receiving its first request
+ *
+ * @param w the worker owning the listening socket
+ * @param res the accepted socket or a negative errno
+ * @param flags the flags of the completion
+ */
+static void uring_accept(worker* w, int res, unsigned flags) {
+    /* the multishot accept ends on errors and has to be queued again */
+    if (!(flags & IORING_CQE_F_MORE) && w->sockfd >= 0) {
+        struct io_uring_sqe* sqe = uring_sqe(&w->ring, URING_ACCEPT);
+        if (sqe) uring_prep_accept(sqe, w->sockfd);
+    }
+    if (res < 0) {
+        if (res != -EAGAIN && res != -EINTR && res != -ECONNABORTED && res != -ECANCELED)
+            fprintf(stderr, "%s: Failed to accept: %s\n", pname, strerror(-res));
+        return;
+    }
+
+    uint64_t start = stats_now();
+    struct sockaddr_in peer;
+    socklen_t peer_len = sizeof(peer);
+    memset(&peer, 0, sizeof(peer));
+    if (accesslog_enabled()) getpeername(res, (struct sockaddr*)&peer, &peer_len);
+
+    connection* c = open_connection(w, res, &peer);
+    if (c == NULL) {
+        fprintf(stderr, "%s: Failed to set up connection: %s\n", pname, strerror(errno));
+        close(res);
+        return;
+    }
+    STATS_ADD(w->stats.accepted, 1);
+    if (uring_queue(w, c) < 0) {
+        close_connection(w, c);
+        return;
+    }
+    stats_record(&w->stats, PHASE_ACCEPT, stats_now() - start);
+}
+
+/**
+ * @brief Handles all available completions
+ *
+ * @param w the worker
+ */
+static void uring_reap(worker* w) {
+    struct io_uring_cqe* cqe;
+    while ((cqe = uring_peek(&w->ring))) {
+        uint64_t data = cqe->user_data;
+        int res = cqe->res;
+        unsigned flags = cqe->flags;
+        uring_advance(&w->ring, 1);
+
+        if (data == URING_ACCEPT) uring_accept(w, res, flags);
+        else if (data > URING_CANCEL) uring_complete(w, (connection*)(uintptr_t)data, res);
+        /* the quit flag is handled by the loop, cancellations and nops need no handling */
+    }
+}
+
+/**
+ * @brief Event loop of a worker using io_uring
+ * @details Every connection has at most one operation (receive, send or
+ * splice) in flight. All operations queued while handling the completions are
+ * submitted with the next wait, so a single system call per iteration
+ * replaces epoll_wait and the reads and writes of the epoll loop. Accepting
+ * is done by a single multishot accept. Shutdown and idle timeouts work like
+ * in epoll_loop.
+ *
+ * @param w the worker
+ * @return 0 once the worker is done, -1 if io_uring isn't available
+ */
+static int uring_loop(worker* w) {
+    int err = uring_init(&w->ring, URING_ENTRIES);
+    if (err < 0) {
+        fprintf(stderr, "%s: io_uring isn't available (%s), using epoll\n", pname, strerror(-err));
+        return -1;
+    }
+
+    struct io_uring_sqe* sqe = uring_sqe(&w->ring, URING_ACCEPT);
+    uring_prep_accept(sqe, w->sockfd);
+    sqe = uring_sqe(&w->ring, URING_QUIT);
+    uring_prep_poll(sqe, quit_fd, POLLIN);
+
+    time_t deadline = 0, now, swept = 0;
+    while (w->sockfd >= 0 || (w->connections && time(NULL) < deadline)) {
+        if (quit && w->sockfd >= 0) {
+            /* stop accepting, the ring keeps the listening socket until the accept is cancelled */
+            if ((sqe = uring_sqe(&w->ring, URING_CANCEL))) uring_prep_cancel(sqe, URING_ACCEPT);
+            close(w->sockfd);
+            w->sockfd = -1;
+            for (connection* c = w->connections; c; c = c->next)
+                if (c->state == CONN_READ && c->req_len == 0) uring_close(c);
+            deadline = time(NULL) + DRAIN_TIMEOUT;
+            continue;
+        }
+
+        /* the log lines must not wait in the batch while the worker sleeps */
+        if (w->connections == NULL) accesslog_flush(&w->log);
+
+        int res = uring_submit(&w->ring, 1, 1000);
+        if (res < 0 && res != -ETIME && res != -EINTR && res != -EBUSY && res != -EAGAIN) {
+            fprintf(stderr, "%s: Failed to wait for events: %s\n", pname, strerror(-res));
+            handle_soft_exit(SIGTERM);
+            break;
+        }
+        uring_reap(w);
+
+        if ((now = time(NULL)) != swept) {
+            for (connection* c = w->idlest; c && c->last_active + IDLE_TIMEOUT <= now; c = c->prev)
+                uring_close(c);
+            accesslog_flush(&w->log);
+            swept = now;
+        }
+    }
+
+    /* the buffers of the connections must stay valid until their operations completed */
+    for (connection* c = w->connections; c; c = c->next) uring_close(c);
+    deadline = time(NULL) + DRAIN_TIMEOUT;
+    while (w->connections && time(NULL) < deadline) {
+        int res = uring_submit(&w->ring, 1, 1000);
+        if (res < 0 && res != -ETIME && res != -EINTR && res != -EBUSY && res != -EAGAIN) break;
+        uring_reap(w);
+    }
+    uring_exit(&w->ring);
+    return 0;
+}
+
+/**
+ * @brief Main function of a worker thread
+ * @details Runs the io_uring loop if it has been selected and is available,
+ * otherwise the epoll loop, and frees the resources of the worker afterwards.
+ *
+ * @param arg the worker
+ * @return always NULL
+ */
+static void* worker_loop(void* arg) {
+    worker* w = arg;
+    if (!w->use_uring || uring_loop(w) < 0) epoll_loop(w);
+
+    if (w->sockfd >= 0) close(w->sockfd);
+    while (w->connections) close_connection(w, w->connections);
+    close(w->epfd);
+    destroy_caches(w);
+    accesslog_flush(&w->log);
+    free(w->log.batch); // left over, if the batch had to be dropped
+    return NULL;
+}
+
+/**
+ * @brief Creates a non-blocking listening socket bound with SO_REUSEPORT
+ *
+ * @param ai the address to bind to
+ * @return the listening socket or -1 if it couldn't be created
+ */
+static int create_listener(struct addrinfo* ai) {
+    int sockfd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (sockfd < 0) {
+        fprintf(stderr, "%s: Failed to create socket: %s\n", pname, strerror(errno));
+        return -1;
+    }
+
+    int optval = 1;
+    if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof optval) < 0 ||
+        setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof optval) < 0) {
+        fprintf(stderr, "%s: Failed to set socket options: %s\n", pname, strerror(errno));
+        close(sockfd);
+        return -1;
+    }
+
+    if (bind(sockfd, ai->ai_addr, ai->ai_addrlen) < 0) {
+        fprintf(stderr, "%s: Failed to bind socket: %s\n", pname, strerror(errno));
+        close(sockfd);
+        return -1;
+    }
+
+    while (listen(sockfd, LISTEN_BACKLOG)) {
+        if (errno != EINTR) {
+            fprintf(stderr, "%s: Failed to listen on port: %s\n", pname, strerror(errno));
+            close(sockfd);
+            return -1;
+        }
+    }
+
+    if (set_nonblocking(sockfd) < 0) {
+        fprintf(stderr, "%s: Failed to set socket options: %s\n", pname, strerror(errno));
+        close(sockfd);
+        return -1;
+    }
+    return sockfd;
+}
+
+/**
+ * @brief Sets up the listening socket and the epoll instance of a worker
+ *
+ * @param w the worker to initialize
+ * @param ai the address to bind to
+ * @return EXIT_SUCCESS or EXIT_FAILURE if the worker couldn't be set up
+ */
+static int setup_worker(worker* w, struct addrinfo* ai) {
+    struct epoll_event ev;
+
+    w->connections = NULL;
+    w->idlest = NULL;
+    w->date_time = 0;
+    w->cache = cache_create(CACHE_SIZE);
+    w->gzcache = cache_create(GZIP_CACHE_SIZE);
+    w->fdcache = fdcache_create();
+    if (w->cache == NULL || w->gzcache == NULL || w->fdcache == NULL) {
+        fprintf(stderr, "%s: Failed to create file cache\n", pname);
+        destroy_caches(w);
+        return EXIT_FAILURE;
+    }
+    if ((w->sockfd = create_listener(ai)) < 0) {
+        destroy_caches(w);
+        return EXIT_FAILURE;
+    }
+
+    w->epfd = epoll_create1(0);
+    if (w->epfd < 0) {
+        fprintf(stderr, "%s: Failed to create epoll instance: %s\n", pname, strerror(errno));
+        close(w->sockfd);
+        destroy_caches(w);
+        return EXIT_FAILURE;
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL; // the listening socket is the only entry without a connection
+    if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->sockfd, &ev) < 0) {
+        fprintf(stderr, "%s: Failed to watch socket: %s\n", pname, strerror(errno));
+        close(w->sockfd);
+        close(w->epfd);
+        destroy_caches(w);
+        return EXIT_FAILURE;
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = &quit_fd;
+    if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, quit_fd, &ev) < 0) {
+        fprintf(stderr, "%s: Failed to watch socket: %s\n", pname, strerror(errno));
+        close(w->sockfd);
+        close(w->epfd);
+        destroy_caches(w);
+        return EXIT_FAILURE;
+    }
     return EXIT_SUCCESS;
 }
 
 /**
  * @brief Creates, binds, and accepts a server-socket and handles http requests.
- * @details Creates, binds, and accepts a server-socket. When bound sucessfully, 
- * a loop is entered which ends if SIGINT or SIGTERM signals are recieved. This 
- * is done by emploing a singnal handeler 'handle_soft_exit' which sets the global
- * flag 'quit' to 1 when either signal is recieved. 
- * When inside the loop, it sequentially accepts connections from clients and 
- * serves them the requested file.
- * 
+ * @details Creates the workers, each with its own server-socket bound to the
+ * same port. When bound sucessfully, every worker enters its event loop which
+ * ends if SIGINT or SIGTERM signals are recieved. This is done by emploing a
+ * singnal handeler 'handle_soft_exit' which sets the global flag 'quit' to 1
+ * when either signal is recieved and wakes up all workers.
+ *
  * @param port The TCP/IP Port the server binds to
  * @param documentroot Path of the directory that requested files are relative to
  * @param indexfile The default file that is sent back, when a directory is requested
- * @return Returns EXIT_SUCCESS when the main loop is exited by 
+ * @param workers The number of worker threads
+ * @param statspath The path the stats page is served at
+ * @param logfile The file the access log is appended to, NULL for stdout
+ * @param logging 0 disables the access log
+ * @param use_uring serve connections with io_uring instead of epoll
+ * @return Returns EXIT_SUCCESS when the main loop is exited by
  */
-int http_server(char* port, char* documentroot, char* indexfile) {
+int http_server(char* port, char* documentroot, char* indexfile, int workers, char* statspath,
+    char* logfile, int logging, int use_uring) {
+    if ((quit_fd = eventfd(0, EFD_NONBLOCK)) < 0) {
+        fprintf(stderr, "%s: Failed to create eventfd: %s\n", pname, strerror(errno));
+        return(EXIT_FAILURE);
+    }
+
     /* Set signal handeler */
     struct sigaction sa;
 	memset(&sa, 0, sizeof(sa));
@@ -132,6 +1109,17 @@ int http_server(char* port, char* documentroot, char* indexfile) {
     sigaction(SIGINT, &sa, NULL);
     sigaction(SIGTERM, &sa, NULL);
 
+    /* writing to a connection closed by the client must not terminate the server */
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sa, NULL);
+
+    /* allow as many open connections as the system permits */
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
     struct addrinfo hints, *ai;
     memset(&hints, 0, sizeof hints);
     hints.ai_family = AF_INET;
@@ -142,143 +1130,621 @@ int http_server(char* port, char* documentroot, char* indexfile) {
     int res = getaddrinfo(NULL, port, &hints, &ai);
     if (res != 0) {
         fprintf(stderr, "%s: Failed to get addrinfo: %s", pname, gai_strerror(res));
-        freeaddrinfo(ai);
         return(EXIT_FAILURE);
     }
 
-    int sockfd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
-    if (sockfd < 0) {
-        fprintf(stderr, "%s: Failed to create socket: %s\n", pname, strerror(errno));
+    if (logging && accesslog_open(logfile) < 0) {
+        fprintf(stderr, "%s: Failed to open access log: %s\n", pname, strerror(errno));
         freeaddrinfo(ai);
         return(EXIT_FAILURE);
     }
 
-    if (bind(sockfd, ai->ai_addr, ai->ai_addrlen) < 0) {
-        fprintf(stderr, "%s: Failed to bind socket: %s\n", pname, strerror(errno));
-        freeaddrinfo(ai);
-        return(EXIT_FAILURE);
+    worker* w = calloc(workers, sizeof(worker));
+    all_workers = w;
+    worker_count = workers;
+    int started = 0;
+    for (; started < workers; started++) {
+        w[started].id = started;
+        w[started].documentroot = documentroot;
+        w[started].indexfile = indexfile;
+        w[started].statspath = statspath;
+        w[started].use_uring = use_uring;
+        if (setup_worker(&w[started], ai) != EXIT_SUCCESS) break;
+        if ((errno = pthread_create(&w[started].thread, NULL, worker_loop, &w[started])) != 0) {
+            fprintf(stderr, "%s: Failed to start worker: %s\n", pname, strerror(errno));
+            close(w[started].sockfd);
+            close(w[started].epfd);
+            destroy_caches(&w[started]);
+            break;
+        }
     }
+    freeaddrinfo(ai);
 
-    int optval = 1;
-    if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof optval) < 0) {
-        fprintf(stderr, "%s: Failed to set socket options: %s\n", pname, strerror(errno));
-        freeaddrinfo(ai);
-        return(EXIT_FAILURE);
+    if (started == workers) {
+        fprintf(stdout, "%s: Created HTTP Server listening on Port: %s\n", pname, port);
+        fprintf(stdout, "%s: Document Root:%s; Indexfile: %s; Workers: %i\n", pname, documentroot, indexfile, workers);
+        fflush(stdout); // the access log is written to stdout without stdio
+    } else {
+        handle_soft_exit(SIGTERM); // stop the workers which allready started
     }
 
-    while (listen(sockfd, MAX_CONNECTIONS)) {
-        if (errno != EINTR) {
-            fprintf(stderr, "%s: Failed to listen on port: %s\n", pname, strerror(errno));
-            freeaddrinfo(ai);
-            return(EXIT_FAILURE);
+    for (int i = 0; i < started; i++)
+        pthread_join(w[i].thread, NULL);
+
+    unsigned long dropped = accesslog_close();
+    if (dropped > 0)
+        fprintf(stderr, "%s: Dropped %lu batches of the access log\n", pname, dropped);
+    fprintf(stdout, "%s: Closing Server and exiting\n", pname);
+    free(w);
+    close(quit_fd);
+
+    return(started == workers ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/**
+ * @brief Returns the "Date:" header line for the current second
+ * @details The line is only formatted once per second and reused by all
+ * responses of the worker in between.
+ *
+ * @param w the worker
+ * @return the header line including "\r\n", its length is stored in w->date_len
+ */
+const char* http_date(worker* w) {
+    time_t now = time(NULL);
+    if (now != w->date_time) {
+        struct tm tm;
+        w->date_len = strftime(w->date, sizeof(w->date), "Date: " RFC822 "\r\n", gmtime_r(&now, &tm));
+        w->date_time = now;
+    }
+    return w->date;
+}
+
+/**
+ * @brief Parses a date in the format of HTTP headers (e.g. "Sun, 06 Nov 1994 08:49:37 GMT")
+ *
+ * @param s the date
+ * @return the time or -1 if the date is invalid
+ */
+static time_t parse_http_date(http_slice s) {
+    char buf[64];
+    struct tm tm;
+    if (s.len >= sizeof(buf)) return -1;
+    memcpy(buf, s.ptr, s.len);
+    buf[s.len] = '\0';
+
+    memset(&tm, 0, sizeof(tm));
+    char* end = strptime(buf, RFC822, &tm);
+    if (end == NULL || *end != '\0') return -1;
+    return timegm(&tm);
+}
+
+/**
+ * @brief Formats the validators of a file: the entity tag and the "ETag:" and "Last-Modified:" header lines
+ * @details The entity tag changes whenever the file is replaced or modified.
+ *
+ * @param etag buffer of 64 bytes for the entity tag
+ * @param fields buffer of 128 bytes for the header lines
+ * @param st inode, size and modification time of the file
+ * @param gzip set for the gzip encoded content, which gets its own tag
+ */
+static void file_validators(char* etag, char* fields, const struct stat* st, int gzip) {
+    struct tm tm;
+    char date[40];
+    snprintf(etag, 64, "\"%llx-%llx-%llx%s\"", (unsigned long long)st->st_ino, (unsigned long long)st->st_size,
+        (unsigned long long)st->st_mtim.tv_sec * 1000000000ULL + st->st_mtim.tv_nsec, gzip ? "-gz" : "");
+    strftime(date, sizeof(date), RFC822, gmtime_r(&st->st_mtim.tv_sec, &tm));
+    snprintf(fields, 128, "ETag: %s\r\nLast-Modified: %s\r\n", etag, date);
+}
+
+/**
+ * @brief Checks, whether a list of entity tags (e.g. of If-None-Match) contains a tag
+ *
+ * @param list the list, "*" matches every tag
+ * @param etag the tag
+ * @param weak if set, tags marked as weak ("W/") are compared as well
+ * @return 1 if the tag is in the list, else 0
+ */
+static int etag_matches(http_slice list, const char* etag, int weak) {
+    size_t i = 0;
+    while (i < list.len) {
+        while (i < list.len && (list.ptr[i] == ' ' || list.ptr[i] == '\t' || list.ptr[i] == ',')) i++;
+        size_t start = i;
+        while (i < list.len && list.ptr[i] != ',') i++;
+        size_t end = i;
+        while (end > start && (list.ptr[end-1] == ' ' || list.ptr[end-1] == '\t')) end--;
+
+        http_slice t = { list.ptr + start, end - start };
+        if (http_slice_eq(t, "*")) return 1;
+        if (t.len > 2 && t.ptr[0] == 'W' && t.ptr[1] == '/') {
+            if (!weak) continue;
+            t.ptr += 2;
+            t.len -= 2;
         }
+        if (http_slice_eq(t, etag)) return 1;
     }
+    return 0;
+}
 
-    fprintf(stdout, "%s: Created HTTP Server listening on Port: %s\n", pname, port);
-    fprintf(stdout, "%s: Document Root:%s; Indexfile: %s\n", pname, documentroot, indexfile);
+/**
+ * @brief Evaluates If-None-Match and If-Modified-Since of the current request
+ *
+ * @param c the connection
+ * @param etag entity tag of the file
+ * @param mtime modification time of the file
+ * @return 1 if the client has the current version of the file, else 0
+ */
+static int not_modified(connection* c, const char* etag, time_t mtime) {
+    if (c->if_none_match.len > 0) return etag_matches(c->if_none_match, etag, 1);
+    return c->if_modified_since >= 0 && mtime <= c->if_modified_since;
+}
 
-    FILE* sockfile;
-    int connfd;
-    struct sockaddr_in in_addr; //optional
-    socklen_t in_addr_len = sizeof(struct sockaddr_in); //optional
-    while (!quit) {
-        if ((connfd = accept(sockfd, (struct sockaddr *) &in_addr, &in_addr_len))<0){
-            fprintf(stderr, "%s: Failed to accept: %s\n", pname, strerror(errno));
-            quit = 1;
-        } else
-        {
-            // fprintf(stdout, "%s: Accepted connection %i\n", pname, in_addr.sin_addr.s_addr);
-            sockfile = fdopen(connfd, "r+");
-            handle_connection(sockfile, documentroot, indexfile);
-            fclose(sockfile);
-        }        
+/**
+ * @brief Checks, whether the client accepts gzip encoded content
+ *
+ * @param list value of the Accept-Encoding header
+ * @return 1 if gzip is accepted with a weight above 0, else 0
+ */
+static int accepts_gzip(http_slice list) {
+    size_t i = 0;
+    while (i < list.len) {
+        while (i < list.len && (list.ptr[i] == ' ' || list.ptr[i] == '\t' || list.ptr[i] == ',')) i++;
+        size_t start = i;
+        while (i < list.len && list.ptr[i] != ',' && list.ptr[i] != ';' && list.ptr[i] != ' ' && list.ptr[i] != '\t') i++;
+        http_slice coding = { list.ptr + start, i - start };
+
+        /* a weight of 0 (e.g. "gzip;q=0.0") refuses the coding */
+        int refused = 0;
+        while (i < list.len && list.ptr[i] != ',') {
+            if ((list.ptr[i] == 'q' || list.ptr[i] == 'Q') && i + 1 < list.len && list.ptr[i+1] == '=') {
+                refused = 1;
+                for (i += 2; i < list.len && list.ptr[i] != ',' && list.ptr[i] != ';'; i++)
+                    if (list.ptr[i] >= '1' && list.ptr[i] <= '9') refused = 0;
+            } else i++;
+        }
+        if (!refused && (http_slice_caseeq(coding, "gzip") || http_slice_caseeq(coding, "x-gzip") ||
+            http_slice_eq(coding, "*")))
+            return 1;
     }
+    return 0;
+}
 
-    fprintf(stdout, "%s: Closing Server and exiting\n", pname);
-    close(sockfd);
-    freeaddrinfo(ai);
+/**
+ * @brief Parses a decimal number at the start of a slice
+ *
+ * @param s the slice, advanced behind the number
+ * @param value the number
+ * @return 0 on success, -1 if there is no number or it is too big
+ */
+static int parse_number(http_slice* s, long long* value) {
+    size_t i = 0;
+    *value = 0;
+    while (i < s->len && s->ptr[i] >= '0' && s->ptr[i] <= '9') {
+        if (*value > (LLONG_MAX - 9) / 10) return -1;
+        *value = *value * 10 + (s->ptr[i++] - '0');
+    }
+    s->ptr += i;
+    s->len -= i;
+    return i > 0 ? 0 : -1;
+}
 
-    return(EXIT_SUCCESS);
+/**
+ * @brief Evaluates Range and If-Range of the current request
+ * @details Only single byte ranges are supported, requests for multiple
+ * ranges are answered with the whole file.
+ *
+ * @param c the connection
+ * @param etag entity tag of the file
+ * @param st size and modification time of the file
+ * @param off first byte of the range
+ * @param len length of the range
+ * @return 1 if a range has to be sent, 0 if the whole file has to be sent, -1 if the range is not satisfiable
+ */
+static int requested_range(connection* c, const char* etag, const struct stat* st, off_t* off, off_t* len) {
+    http_slice s = c->range;
+    long long first, last = st->st_size - 1;
+    if (s.len < 6 || strncasecmp(s.ptr, "bytes=", 6) != 0 || memchr(s.ptr, ',', s.len)) return 0;
+
+    /* a range of an outdated version of the file is useless */
+    if (c->if_range.len > 0) {
+        if (c->if_range.ptr[0] == '"') {
+            if (!http_slice_eq(c->if_range, etag)) return 0;
+        } else if (parse_http_date(c->if_range) != st->st_mtim.tv_sec) return 0;
+    }
+
+    s.ptr += 6;
+    s.len -= 6;
+    if (s.len > 0 && s.ptr[0] == '-') { // the last bytes of the file
+        s.ptr++;
+        s.len--;
+        if (parse_number(&s, &first) < 0 || s.len > 0) return 0;
+        if (first == 0 || st->st_size == 0) return -1;
+        first = first < st->st_size ? st->st_size - first : 0;
+    } else {
+        if (parse_number(&s, &first) < 0 || s.len == 0 || s.ptr[0] != '-') return 0;
+        s.ptr++;
+        s.len--;
+        if (s.len > 0) {
+            long long end;
+            if (parse_number(&s, &end) < 0 || s.len > 0 || end < first) return 0;
+            if (end < last) last = end;
+        }
+        if (first >= st->st_size) return -1;
+    }
+
+    *off = first;
+    *len = last - first + 1;
+    return 1;
 }
 
 /**
  * @brief Sends HTTP Error Message
- * 
- * @param sockfile pointer to the socket
+ *
+ * @param c the connection
  * @param scode HTTP Statuscode
  * @param sname HTTP Statuscode Name
  * @return
  */
-int send_error(FILE* sockfile, int scode, char* sname) {
+int send_error(connection* c, int scode, char* sname) {
     int len = 71 + 2*3 + 2*strlen(sname); // 71 fixed Chars + 2x statuscode(3B) + 2xstatuscodename
-    send_header(sockfile, scode, sname, len);
-    fprintf(sockfile, "<html><head><title>%i %s</title></head>", scode, sname);
-    fprintf(sockfile, "<body><p><b>%i:</b> %s</p></body></html>", scode, sname);
-    fflush(sockfile);
+    send_header(c, scode, sname, len, "Content-Type: text/html\r\n");
+    c->out_len += snprintf(c->out + c->out_len, OUT_BUF_SIZE - c->out_len,
+        "<html><head><title>%i %s</title></head>"
+        "<body><p><b>%i:</b> %s</p></body></html>", scode, sname, scode, sname);
+    c->iov[0].iov_len = c->out_len;
     return EXIT_SUCCESS;
 }
 
 /**
  * @brief Sends HTTP Header including date, content-type and content-lenght
- * 
- * @param sockfile pointer to the socket
-
+ * @details The header is written into the output buffer of the connection,
+ * which is sent as soon as the socket is writeable.
+ *
+ * @param c the connection
  * @param scode HTTP Statuscode
  * @param sname HTTP Statuscode Name
- * @param content_len Length of Following file in Bytes
+ * @param content_len Length of Following file in Bytes, -1 if the response has no body (304)
+ * @param fields additional header lines, each terminated by "\r\n"
  * @return
  */
-int send_header(FILE* sockfile, int scode, char* sname, long content_len) {
+int send_header(connection* c, int scode, char* sname, long content_len, const char* fields) {
+    char length[48] = "";
+    if (content_len >= 0) snprintf(length, sizeof(length), "Content-Length: %li\r\n", content_len);
+    c->out_len = snprintf(c->out, OUT_BUF_SIZE,
+        "HTTP/1.1 %i %s\r\n"
+        "%s"
+        "%s"
+        "%s"
+        "Connection: %s\r\n"
+        "\r\n", scode, sname, http_date(c->w), length, fields,
+        c->keep_alive ? "keep-alive" : "close");
+
+    c->status = scode;
+    c->state = CONN_WRITE;
+    c->iov[0].iov_base = c->out;
+    c->iov[0].iov_len = c->out_len;
+    c->iovcnt = 1;
+    c->iov_idx = 0;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Sends the stats of all workers
+ * @details The stats are summed up while the other workers keep running, so
+ * the page is only a consistent snapshot for each single counter. It is
+ * rendered as plain text, or in the Prometheus format if the query contains
+ * "format=prometheus".
+ *
+ * @param c the connection
+ * @param query the query of the request (without '?')
+ */
+static void send_stats(connection* c, http_slice query) {
+    stats sum;
+    memset(&sum, 0, sizeof(sum));
+    for (int i = 0; i < worker_count; i++) stats_add(&sum, &all_workers[i].stats);
+
+    char* body = malloc(STATS_BUF_SIZE);
+    if (body == NULL) {
+        send_error(c, 500, "Internal Server Error");
+        return;
+    }
+    int prometheus = memmem(query.ptr, query.len, "format=prometheus", 17) != NULL;
+    size_t len = stats_render(body, STATS_BUF_SIZE, &sum, prometheus);
+
+    send_header(c, 200, "OK", len, prometheus ?
+        "Content-Type: text/plain; version=0.0.4\r\nCache-Control: no-store\r\n" :
+        "Content-Type: text/plain; charset=utf-8\r\nCache-Control: no-store\r\n");
+    c->body = body;
+    c->iov[1].iov_base = body;
+    c->iov[1].iov_len = len;
+    c->iovcnt = 2;
+}
+
+/**
+ * @brief Sends a cached file with its pre-rendered header
+ * @details The header, the current date and the connection header and the
+ * content are sent with a single gathering write, the entry stays referenced
+ * until the response has been sent.
+ *
+ * @param c the connection
+ * @param e the referenced cache entry
+ */
+static void send_cached(connection* c, cache_entry* e) {
+    /* the date is copied, because the line of the worker changes every second */
+    c->out_len = snprintf(c->out, OUT_BUF_SIZE, "%sConnection: %s\r\n",
+        http_date(c->w), c->keep_alive ? "keep-alive" : "close");
+
+    c->entry = e;
+    c->status = 200;
+    c->state = CONN_WRITE;
+    c->iov[0].iov_base = e->data;
+    c->iov[0].iov_len = e->header_len;
+    c->iov[1].iov_base = c->out;
+    c->iov[1].iov_len = c->out_len;
+    c->iov[2].iov_base = e->data + e->header_len;
+    c->iov[2].iov_len = 2 + e->size;
+    c->iovcnt = 3;
+    c->iov_idx = 0;
+}
+
+/** @brief fills the validated fields of a stat from a cache entry */
+static void entry_stat(cache_entry* e, struct stat* st) {
+    st->st_ino = e->ino;
+    st->st_size = e->file_size;
+    st->st_mtim = e->mtime;
+}
+
+/**
+ * @brief Sends a file or a cache entry, answering conditional and range requests
+ * @details Conditional requests are answered with 304 before the content is
+ * touched, a requested byte range is sent with 206 from the cache or with the
+ * offset of sendfile. Small files are added to the file cache of the worker,
+ * precompressed siblings to the compression cache, so their header never
+ * answers a direct request for the sibling.
+ *
+ * @param c the connection
+ * @param path resolved path of the file, key of the cache entry
+ * @param e the referenced cache entry or NULL
+ * @param f the referenced open file, if e is NULL
+ * @param st the stat of the file
+ * @param fields header lines describing the content (type and encoding)
+ * @param gzip set if the content is gzip encoded, ranges are not supported then
+ */
+static void send_content(connection* c, const char* path, cache_entry* e, fd_entry* f, struct stat* st,
+    const char* fields, int gzip) {
+    char etag[64], validators[128], header[640], range_fields[512];
+    file_validators(etag, validators, st, gzip);
+    off_t size = e ? (off_t)e->size : st->st_size;
+
+    off_t off = 0, len = size;
+    int range = 0;
+    if (not_modified(c, etag, st->st_mtim.tv_sec)) {
+        snprintf(header, sizeof(header), "%s%s", gzip ? "Vary: Accept-Encoding\r\n" : "", validators);
+        send_header(c, 304, "Not Modified", -1, header);
+        range = -2;
+    } else if (!gzip && c->range.len > 0 && (range = requested_range(c, etag, st, &off, &len)) < 0) {
+        snprintf(header, sizeof(header), "Content-Range: bytes */%lli\r\n", (long long)size);
+        send_header(c, 416, "Range Not Satisfiable", 0, header);
+    }
+    if (range < 0) { // no content is sent
+        if (e) cache_release(e);
+        else fdcache_release(f);
+        return;
+    }
+
+    if (range > 0) {
+        snprintf(range_fields, sizeof(range_fields), "%sContent-Range: bytes %lli-%lli/%lli\r\n%s", fields,
+            (long long)off, (long long)(off + len - 1), (long long)size, validators);
+        send_header(c, 206, "Partial Content", len, range_fields);
+        if (e) {
+            c->entry = e;
+            c->iov[1].iov_base = e->data + e->header_len + 2 + off;
+            c->iov[1].iov_len = len;
+            c->iovcnt = 2;
+        } else {
+            c->file = f;
+            c->file_fd = f->fd;
+            c->file_off = off;
+            c->file_len = off + len;
+        }
+        return;
+    }
+
+    if (e) {
+        send_cached(c, e);
+        return;
+    }
+
+    snprintf(range_fields, sizeof(range_fields), "%s%s%s", fields, gzip ? "" : "Accept-Ranges: bytes\r\n", validators);
+    if (size <= CACHE_MAX_FILE) {
+        snprintf(header, sizeof(header),
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Length: %lli\r\n"
+            "%s", (long long)size, range_fields);
+        if ((e = cache_insert(gzip ? c->w->gzcache : c->w->cache, path, f->fd, st, header, time(NULL)))) {
+            fdcache_release(f);
+            send_cached(c, e);
+            return;
+        }
+    }
+
+    send_header(c, 200, "OK", size, range_fields);
+    c->file = f;
+    c->file_fd = f->fd;
+    c->file_off = 0;
+    c->file_len = size;
+}
+
+/**
+ * @brief Sends the precompressed sibling (path + ".gz") of a file, if there is one
+ *
+ * @param c the connection
+ * @param filepath filepath of the requested file
+ * @param fields header lines describing the content
+ * @return 0 if the sibling is sent, -1 if there is none
+ */
+static int send_precompressed(connection* c, char* filepath, const char* fields) {
+    char gzpath[PATH_MAX];
+    struct stat st;
+    if (snprintf(gzpath, sizeof(gzpath), "%s.gz", filepath) >= (int)sizeof(gzpath)) return -1;
+
+    /* the sibling is cached with the compressed contents, whose keys never end
+     * with ".gz" (gzip files aren't compressed again) */
+    time_t now = time(NULL);
+    cache_entry* e = cache_lookup(c->w->gzcache, gzpath, now);
+    fd_entry* f = NULL;
+    if (e) entry_stat(e, &st);
+    else {
+        /* a missing sibling is remembered by the open file cache */
+        if ((f = fdcache_open(c->w->fdcache, gzpath, now)) == NULL) return -1;
+        st = f->st;
+    }
+
+    send_content(c, gzpath, e, f, &st, fields, 1);
+    return 0;
+}
+
+/**
+ * @brief Compresses the content of a file and adds it to the compression cache
+ * @details If compressing doesn't pay off or the result is too big for the
+ * cache, an entry without header is added instead, which marks the file as
+ * to be sent uncompressed, so the work isn't repeated for every request.
+ *
+ * @param c the connection
+ * @param filepath filepath of the file
+ * @param data content of the file
+ * @param st stat of the file
+ * @param fields header lines describing the compressed content
+ * @return the referenced entry or NULL on failure
+ */
+static cache_entry* compress_file(connection* c, char* filepath, const char* data, struct stat* st,
+    const char* fields) {
+    char etag[64], validators[128], header[512];
     time_t now = time(NULL);
-    char timebuf[128];
-    strftime(timebuf, sizeof(timebuf), RFC822, gmtime(&now));
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, GZIP_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return NULL;
+
+    uLong bound = deflateBound(&zs, st->st_size);
+    char* out = malloc(bound);
+    int res = Z_MEM_ERROR;
+    if (out) {
+        zs.next_in = (Bytef*)data;
+        zs.avail_in = st->st_size;
+        zs.next_out = (Bytef*)out;
+        zs.avail_out = bound;
+        res = deflate(&zs, Z_FINISH);
+    }
+    size_t len = zs.total_out;
+    deflateEnd(&zs);
 
-    fprintf(sockfile, "HTTP/1.1 %i %s\r\n", scode, sname);
-    fprintf(sockfile, "Date: %s\r\n", timebuf);
-    // fprintf(sockfile, "Content-type: text/html\r\n");
-    fprintf(sockfile, "Content-Length: %li\r\n", content_len);
-    fprintf(sockfile, "Connection: close\r\n");
-    fprintf(sockfile, "\r\n");
+    cache_entry* e = NULL;
+    if (res == Z_STREAM_END && len < (size_t)st->st_size) {
+        file_validators(etag, validators, st, 1);
+        snprintf(header, sizeof(header),
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Length: %zu\r\n"
+            "%s%s", len, fields, validators);
+        e = cache_insert_data(c->w->gzcache, filepath, st, header, out, len, now);
+    }
+    if (e == NULL && (res == Z_STREAM_END || res == Z_OK))
+        e = cache_insert_data(c->w->gzcache, filepath, st, "", NULL, 0, now);
+    free(out);
+    return e;
+}
 
-    return EXIT_SUCCESS;
+/**
+ * @brief Sends the compressed content of a file from the compression cache
+ * @details The file is compressed on the first request, if its type
+ * compresses well and its size is within the limits.
+ *
+ * @param c the connection
+ * @param filepath filepath of the requested file
+ * @param fields header lines describing the compressed content
+ * @param e the referenced entry of the file cache or NULL
+ * @param f the referenced open file, if e is NULL
+ * @param st the stat of the file
+ * @return 0 if the compressed content is sent, -1 if the file has to be sent uncompressed
+ */
+static int send_compressed(connection* c, char* filepath, const char* fields, cache_entry* e, fd_entry* f,
+    struct stat* st) {
+    cache_entry* ge = cache_lookup(c->w->gzcache, filepath, time(NULL));
+    if (ge == NULL) {
+        if (st->st_size < GZIP_MIN_FILE || st->st_size > GZIP_MAX_FILE) return -1;
+
+        /* compress the cached content or read the file */
+        char* data = e ? e->data + e->header_len + 2 : malloc(st->st_size);
+        if (data == NULL) return -1;
+        for (off_t off = 0; e == NULL && off < st->st_size;) {
+            ssize_t n = pread(f->fd, data + off, st->st_size - off, off);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                free(data);
+                return -1;
+            }
+            off += n;
+        }
+        ge = compress_file(c, filepath, data, st, fields);
+        if (e == NULL) free(data);
+        if (ge == NULL) return -1;
+    }
+
+    if (ge->header_len == 0) { // not worth compressing
+        cache_release(ge);
+        return -1;
+    }
+    if (e) cache_release(e);
+    else fdcache_release(f);
+
+    struct stat gst;
+    entry_stat(ge, &gst);
+    send_content(c, filepath, ge, NULL, &gst, fields, 1);
+    return 0;
 }
 
 /**
  * @brief Sends HTTP response with file
- * 
- * @param sockfile pointer to the socket
+ * @details Small files are served from the cache of the worker and read into
+ * it on the first request. Bigger files are sent with sendfile whenever the
+ * socket is writeable. Clients accepting gzip get the precompressed sibling
+ * of the file or its compressed content from the compression cache.
+ *
+ * @param c the connection
  * @param filepath filepath of the requested file
  * @return
  */
-int send_file(FILE* sockfile, char* filepath) {
-    FILE* webpage;
+int send_file(connection* c, char* filepath) {
+    const mime_type* type = mime_lookup(filepath);
+    char fields[256], gzfields[256];
+    snprintf(fields, sizeof(fields), "Content-Type: %s\r\n%s", type->type,
+        type->compress ? "Vary: Accept-Encoding\r\n" : "");
+    snprintf(gzfields, sizeof(gzfields), "Content-Type: %s\r\nContent-Encoding: gzip\r\nVary: Accept-Encoding\r\n",
+        type->type);
 
-    while ((webpage=fopen(filepath, "r"))==NULL) {
-        if (errno != EINTR) {
-            fprintf(stderr, "%s: File not found\n", pname);
-            send_error(sockfile, 404, "Not Found");
+    /* compressed content is only sent as a whole */
+    int gzip = c->gzip && c->range.len == 0;
+    if (gzip && send_precompressed(c, filepath, gzfields) == 0) return EXIT_SUCCESS;
+
+    time_t now = time(NULL);
+    cache_entry* e = cache_lookup(c->w->cache, filepath, now);
+    fd_entry* f = NULL;
+    struct stat st;
+
+    if (e) entry_stat(e, &st);
+    else {
+        /* only regular files can be sent */
+        if ((f = fdcache_open(c->w->fdcache, filepath, now)) == NULL) {
+            if (errno == ENOMEM || errno == EMFILE || errno == ENFILE)
+                send_error(c, 503, "Service Unavailable");
+            else
+                send_error(c, 404, "Not Found");
             return EXIT_FAILURE;
         }
+        st = f->st;
     }
-    
-    /* get filelength */
-    fseek(webpage, 0, SEEK_END);
-    long content_len = ftell(webpage);
-    fseek(webpage, 0, SEEK_SET);
-    
-    send_header(sockfile, 200, "OK", content_len);
-
-    int chars_read;
-    // char *data = malloc(content_len);
-    // while ((chars_read = fread(data, 1, content_len, webpage))>0)    
-    //     fwrite(data, 1, chars_read, sockfile);
-    // free(data);
-    char data[2048];
-    while ((chars_read = fread(data, 1, 2048, webpage)) > 0)    
-        fwrite(data, 1, chars_read, sockfile);
-
-    fclose(webpage);
-    fflush(sockfile);
+
+    if (gzip && type->compress && send_compressed(c, filepath, gzfields, e, f, &st) == 0) return EXIT_SUCCESS;
+
+    send_content(c, filepath, e, f, &st, fields, 0);
     return EXIT_SUCCESS;
 }
 
@@ -293,10 +1759,10 @@ int main (int argc, char **argv){
     pname = argv[0];
 
     /* Argument Parsing */
-	char *p_arg = NULL, *i_arg = NULL, *indexfile, *docroot, *port;
-	int opt_p = 0, opt_i = 0, c;
+	char *p_arg = NULL, *i_arg = NULL, *w_arg = NULL, *s_arg = NULL, *l_arg = NULL, *indexfile, *docroot, *port;
+	int opt_p = 0, opt_i = 0, opt_w = 0, opt_s = 0, opt_l = 0, opt_q = 0, opt_u = 0, workers = 1, c;
 
-	while((c=getopt(argc, argv, "p:i:")) != -1) {
+	while((c=getopt(argc, argv, "p:i:w:s:l:qu")) != -1) {
  		switch (c){
  			case 'p':// port
  				opt_p++;
@@ -306,6 +1772,24 @@ int main (int argc, char **argv){
  				opt_i++;
 				i_arg = optarg;
  				break;
+ 			case 'w':// number of worker threads
+ 				opt_w++;
+				w_arg = optarg;
+ 				break;
+ 			case 's':// path of the stats page
+ 				opt_s++;
+				s_arg = optarg;
+ 				break;
+ 			case 'l':// access log file
+ 				opt_l++;
+				l_arg = optarg;
+ 				break;
+ 			case 'q':// no access log
+ 				opt_q++;
+ 				break;
+ 			case 'u':// io_uring instead of epoll
+ 				opt_u++;
+ 				break;
 
  			case '?':
  			default:// illegal arguments
@@ -313,7 +1797,7 @@ int main (int argc, char **argv){
  				break;
  		}
  	}
- 	if (opt_p > 1 || opt_i > 1) {
+ 	if (opt_p > 1 || opt_i > 1 || opt_w > 1 || opt_s > 1 || opt_l > 1 || opt_q > 1 || opt_u > 1) {
  		fprintf(stderr, "%s:, Every option can only be used unce!\n", pname);
  		usage(argv[0]);
  	}
@@ -324,6 +1808,25 @@ int main (int argc, char **argv){
     if (opt_i==0) indexfile = "index.html";
     else indexfile = i_arg;
 
+    if (opt_w) {
+        char *end;
+        long n = strtol(w_arg, &end, 10);
+        if (*end != '\0' || n < 1 || n > MAX_WORKERS) {
+            fprintf(stderr, "%s: The number of workers has to be between 1 and %i\n", pname, MAX_WORKERS);
+            usage(argv[0]);
+        }
+        workers = n;
+    }
+
+    if (opt_s && s_arg[0] != '/') {
+        fprintf(stderr, "%s: The path of the stats page has to start with '/'\n", pname);
+        usage(argv[0]);
+    }
+    if (opt_l && opt_q) {
+        fprintf(stderr, "%s: -l and -q can't be used together\n", pname);
+        usage(argv[0]);
+    }
+
     if (argc-optind!=1) {
         fprintf(stderr, "%s: A Document Root has to be specified\n", pname);
         usage(argv[0]);
@@ -331,5 +1834,5 @@ int main (int argc, char **argv){
 
     docroot = argv[optind];
 
-    return(http_server(port, docroot, indexfile));
+    return(http_server(port, docroot, indexfile, workers, opt_s ? s_arg : "/__stats", l_arg, !opt_q, opt_u));
 }
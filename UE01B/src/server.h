@@ -4,20 +4,136 @@
  * @date 31.10.2019
  *
  * @brief A simple HTTP Server
- * @details Creates an HTTP Server which handles GET request. 
+ * @details Creates an HTTP Server which handles GET request.
  * The documentroot has to be passed.
  * The default file to be transmitted when a folder is requested is called
  * indexfile and can be specified with the -i argument (default: index.html).
  * The Port to bind to can be specified with -p (default: 8080)
+ * Counters and latencies of the server are served at -s (default: /__stats),
+ * every request is logged to stdout or the file given with -l, -q disables
+ * the access log. With -u connections are served with io_uring instead of epoll.
  */
 #ifndef SERVER_H_   /* Include guard */
 #define SERVER_H_
 
-int handle_connection(FILE* sockfile, char* documentroot, char* indexfile);
-int send_file(FILE* sockfile, char* filepath);
-int http_server(char* port, char* documentroot, char* indexfile);
-int send_error(FILE* sockfile, int scode, char* sname);
-int send_header(FILE* sockfile, int statuscode, char* statusname, long content_len);
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <time.h>
+
+#include "accesslog.h"
+#include "fdcache.h"
+#include "filecache.h"
+#include "http_parser.h"
+#include "stats.h"
+#include "uring.h"
+
+#define MAX_EVENTS 256      // epoll events fetched with one epoll_wait call
+#define REQ_BUF_SIZE 8192   // max. size of a request header
+#define OUT_BUF_SIZE 4096   // buffer for the response header and error pages
+#define DRAIN_TIMEOUT 5     // seconds in-flight requests may take after a quit signal
+#define MAX_WORKERS 256     // upper limit for the number of worker threads
+#define IDLE_TIMEOUT 5      // seconds a connection may be idle before it is closed
+#define MAX_REQUESTS 1000   // max. number of requests served over one connection
+#define GZIP_CACHE_SIZE (16 << 20)  // max. number of bytes in the compression cache of a worker
+#define GZIP_MIN_FILE 256           // smaller files are not compressed
+#define GZIP_MAX_FILE (4 << 20)     // bigger files are not compressed
+#define GZIP_LEVEL 6                // zlib compression level
+#define URING_SPLICE_MAX 65536      // max. bytes moved by one splice of the io_uring loop (size of a pipe)
+
+/** @brief the phases a connection goes through */
+typedef enum conn_state {
+    CONN_READ,      /** waiting for a complete request header */
+    CONN_WRITE      /** sending the response header and body, afterwards the
+                        connection is closed or waits for the next request */
+} conn_state;
+
+/** @brief the io_uring operation a connection is waiting for */
+typedef enum conn_op {
+    OP_NONE,        /** no operation in flight */
+    OP_RECV,        /** receiving the request */
+    OP_SEND,        /** sending the pending output */
+    OP_SPLICE_IN,   /** moving a part of the file into the pipe */
+    OP_SPLICE_OUT   /** moving the piped part of the file into the socket */
+} conn_op;
+
+/** @brief state of a single client connection */
+typedef struct connection {
+    int fd;                     /** socket of the connection */
+    conn_state state;           /** current phase of the connection */
+    struct worker* w;           /** worker serving the connection */
+    struct sockaddr_in peer;    /** address of the client */
+    char req[REQ_BUF_SIZE];     /** received bytes of the current and pipelined requests */
+    size_t req_len;             /** number of bytes in req */
+    http_request parser;        /** the parsed header of the current request */
+    size_t req_used;            /** length of the request currently served, the
+                                    rest of req belongs to pipelined requests */
+    int requests;               /** number of requests served over the connection */
+    int keep_alive;             /** wait for another request after the response */
+    time_t if_modified_since;   /** If-Modified-Since of the current request, -1 if there is none */
+    http_slice if_none_match;   /** If-None-Match of the current request, empty if there is none */
+    http_slice range;           /** Range of the current request, empty if there is none */
+    http_slice if_range;        /** If-Range of the current request, empty if there is none */
+    int gzip;                   /** the client accepts gzip encoded content */
+    int status;                 /** status code of the current response */
+    size_t sent;                /** bytes of the current response sent so far */
+    uint64_t started;           /** time parsing of the current request started (ns) */
+    uint64_t parsed;            /** time the current request was parsed (ns) */
+    uint64_t prepared;          /** time the current response was ready to be sent (ns) */
+    uint32_t events;            /** events the connection is watched for by epoll */
+    time_t last_active;         /** last time the connection made progress */
+    char out[OUT_BUF_SIZE];     /** header or error page of the response */
+    size_t out_len;             /** number of bytes in out */
+    struct iovec iov[3];        /** pending output (out or the parts of a cached response) */
+    int iovcnt;                 /** number of entries in iov */
+    int iov_idx;                /** first entry in iov which hasn't been sent completely */
+    cache_entry* entry;         /** cached file beeing sent, NULL if there is none */
+    char* body;                 /** generated body beeing sent (stats page), NULL if there is none */
+    fd_entry* file;             /** referenced open file beeing sent, NULL if there is none */
+    int file_fd;                /** file to be sent after out (fd of file), -1 if there is none */
+    off_t file_off;             /** offset of the next byte to send from file_fd */
+    off_t file_len;             /** offset after the last byte to send from file_fd */
+    int pipefd[2];              /** pipe for splicing the file, if sendfile isn't supported */
+    size_t piped;               /** number of file bytes waiting in the pipe */
+    conn_op op;                 /** io_uring operation in flight */
+    int closing;                /** the socket has been shut down, close once op completes */
+    struct msghdr msg;          /** message of the io_uring send, must live until it completes */
+    struct connection *prev;    /** more recently active connection */
+    struct connection *next;    /** less recently active connection */
+} connection;
+
+/** @brief state of a worker thread, which serves its own set of connections */
+typedef struct worker {
+    int id;                     /** number of the worker */
+    pthread_t thread;           /** thread running the event loop of the worker */
+    int sockfd;                 /** listening socket of the worker, -1 once closed */
+    int epfd;                   /** epoll instance of the worker */
+    char* documentroot;         /** directory that requested files are relative to */
+    char* indexfile;            /** file sent when a directory is requested */
+    char* statspath;            /** path the stats page is served at */
+    int use_uring;              /** serve the connections with io_uring instead of epoll */
+    uring ring;                 /** the ring of the io_uring loop */
+    connection* connections;    /** open connections, the most recently active one first */
+    connection* idlest;         /** least recently active connection */
+    filecache* cache;           /** cache of small, frequently requested files */
+    filecache* gzcache;         /** cache of the compressed content of files */
+    fdcache* fdcache;           /** cache of open files and missing paths */
+    time_t date_time;           /** time date has been generated for */
+    char date[64];              /** "Date:" header line of the current second */
+    size_t date_len;            /** length of date */
+    stats stats;                /** counters and latencies, only written by the worker itself */
+    access_log log;             /** access log lines not yet handed to the writer */
+} worker;
+
+int handle_connection(worker* w, connection* c);
+int send_file(connection* c, char* filepath);
+const char* http_date(worker* w);
+int http_server(char* port, char* documentroot, char* indexfile, int workers, char* statspath,
+    char* logfile, int logging, int use_uring);
+int send_error(connection* c, int scode, char* sname);
+int send_header(connection* c, int statuscode, char* statusname, long content_len, const char* fields);
 
 
 #endif // SERVER_H_
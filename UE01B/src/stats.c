@@ -0,0 +1,164 @@
+/**
+ * @file stats.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Request counters and latency histograms of the server
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "stats.h"
+
+/** @brief names of the phases as shown on the stats page */
+static const char* phase_names[PHASE_COUNT] = { "accept", "parse", "open", "send", "total" };
+
+/** @brief loads a value written by another worker */
+#define LOAD(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+
+uint64_t stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void stats_record(stats* s, stats_phase p, uint64_t ns) {
+    stats_histogram* h = &s->phase[p];
+    int b = ns ? 64 - __builtin_clzll(ns) : 0;
+    if (b >= STATS_BUCKETS) b = STATS_BUCKETS - 1;
+
+    STATS_ADD(h->count[b], 1);
+    STATS_ADD(h->sum, ns);
+    if (ns > h->max) __atomic_store_n(&h->max, ns, __ATOMIC_RELAXED);
+}
+
+void stats_add(stats* sum, const stats* s) {
+    sum->accepted += LOAD(s->accepted);
+    sum->closed += LOAD(s->closed);
+    sum->requests += LOAD(s->requests);
+    for (int i = 0; i < 6; i++) sum->responses[i] += LOAD(s->responses[i]);
+    sum->bytes += LOAD(s->bytes);
+
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        const stats_histogram* h = &s->phase[p];
+        for (int b = 0; b < STATS_BUCKETS; b++) sum->phase[p].count[b] += LOAD(h->count[b]);
+        sum->phase[p].sum += LOAD(h->sum);
+        uint64_t max = LOAD(h->max);
+        if (max > sum->phase[p].max) sum->phase[p].max = max;
+    }
+}
+
+/** @brief returns the number of durations in a histogram */
+static uint64_t hist_total(const stats_histogram* h) {
+    uint64_t n = 0;
+    for (int b = 0; b < STATS_BUCKETS; b++) n += h->count[b];
+    return n;
+}
+
+/**
+ * @brief Estimates a percentile of a histogram
+ *
+ * @param h the histogram
+ * @param p the percentile (0 - 100)
+ * @return the upper bound of the bucket containing the percentile (ns)
+ */
+static uint64_t hist_percentile(const stats_histogram* h, double p) {
+    uint64_t n = hist_total(h), seen = 0;
+    for (int b = 0; b < STATS_BUCKETS; b++) {
+        seen += h->count[b];
+        if (seen > 0 && seen >= n * p / 100) {
+            uint64_t upper = b + 1 < STATS_BUCKETS ? (uint64_t)1 << b : h->max;
+            return upper < h->max ? upper : h->max;
+        }
+    }
+    return h->max;
+}
+
+/** @brief appends formatted text to the page, text which doesn't fit is dropped */
+static void append(char* buf, size_t size, size_t* len, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf + *len, size - *len, fmt, ap);
+    va_end(ap);
+    if (n > 0) *len = *len + n < size ? *len + n : size - 1;
+}
+
+/** @brief renders the human readable page */
+static size_t render_text(char* buf, size_t size, const stats* s) {
+    size_t len = 0;
+    append(buf, size, &len,
+        "connections accepted: %llu\n"
+        "connections open:     %llu\n"
+        "requests:             %llu\n"
+        "bytes sent:           %llu\n"
+        "responses:            1xx %llu, 2xx %llu, 3xx %llu, 4xx %llu, 5xx %llu\n\n",
+        (unsigned long long)s->accepted, (unsigned long long)(s->accepted - s->closed),
+        (unsigned long long)s->requests, (unsigned long long)s->bytes,
+        (unsigned long long)s->responses[1], (unsigned long long)s->responses[2],
+        (unsigned long long)s->responses[3], (unsigned long long)s->responses[4],
+        (unsigned long long)s->responses[5]);
+
+    append(buf, size, &len, "%-8s %12s %12s %12s %12s %12s %12s\n",
+        "phase", "count", "mean [us]", "p50 [us]", "p90 [us]", "p99 [us]", "max [us]");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        const stats_histogram* h = &s->phase[p];
+        uint64_t n = hist_total(h);
+        append(buf, size, &len, "%-8s %12llu %12.1f %12.1f %12.1f %12.1f %12.1f\n", phase_names[p],
+            (unsigned long long)n, n ? h->sum / 1e3 / n : 0.0, hist_percentile(h, 50) / 1e3,
+            hist_percentile(h, 90) / 1e3, hist_percentile(h, 99) / 1e3, h->max / 1e3);
+    }
+    return len;
+}
+
+/** @brief renders the page in the Prometheus text exposition format */
+static size_t render_prometheus(char* buf, size_t size, const stats* s) {
+    size_t len = 0;
+    append(buf, size, &len,
+        "# HELP http_connections_accepted_total Accepted connections.\n"
+        "# TYPE http_connections_accepted_total counter\n"
+        "http_connections_accepted_total %llu\n"
+        "# HELP http_connections_open Currently open connections.\n"
+        "# TYPE http_connections_open gauge\n"
+        "http_connections_open %llu\n"
+        "# HELP http_requests_total Requests answered completely.\n"
+        "# TYPE http_requests_total counter\n"
+        "http_requests_total %llu\n"
+        "# HELP http_sent_bytes_total Bytes sent, including headers.\n"
+        "# TYPE http_sent_bytes_total counter\n"
+        "http_sent_bytes_total %llu\n"
+        "# HELP http_responses_total Responses per status class.\n"
+        "# TYPE http_responses_total counter\n",
+        (unsigned long long)s->accepted, (unsigned long long)(s->accepted - s->closed),
+        (unsigned long long)s->requests, (unsigned long long)s->bytes);
+    for (int i = 1; i < 6; i++)
+        append(buf, size, &len, "http_responses_total{code=\"%ixx\"} %llu\n", i,
+            (unsigned long long)s->responses[i]);
+
+    append(buf, size, &len,
+        "# HELP http_phase_seconds Time spent in the phases of a request.\n"
+        "# TYPE http_phase_seconds histogram\n");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        const stats_histogram* h = &s->phase[p];
+        uint64_t n = 0;
+        for (int b = 0; b < STATS_BUCKETS - 1; b++) {
+            n += h->count[b];
+            append(buf, size, &len, "http_phase_seconds_bucket{phase=\"%s\",le=\"%.9g\"} %llu\n",
+                phase_names[p], ((uint64_t)1 << b) / 1e9, (unsigned long long)n);
+        }
+        n += h->count[STATS_BUCKETS - 1];
+        append(buf, size, &len,
+            "http_phase_seconds_bucket{phase=\"%s\",le=\"+Inf\"} %llu\n"
+            "http_phase_seconds_sum{phase=\"%s\"} %.9f\n"
+            "http_phase_seconds_count{phase=\"%s\"} %llu\n",
+            phase_names[p], (unsigned long long)n, phase_names[p], h->sum / 1e9,
+            phase_names[p], (unsigned long long)n);
+    }
+    return len;
+}
+
+size_t stats_render(char* buf, size_t size, const stats* s, int prometheus) {
+    buf[0] = '\0';
+    return prometheus ? render_prometheus(buf, size, s) : render_text(buf, size, s);
+}
@@ -0,0 +1,88 @@
+/**
+ * @file stats.h
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Request counters and latency histograms of the server
+ * @details Every worker owns a stats structure and is the only thread writing
+ * to it, so no locks or read-modify-write instructions are needed. The values
+ * are stored with relaxed atomic stores, which lets any worker sum up the
+ * stats of all workers while they keep running. Latencies are counted in
+ * histograms with power-of-two buckets (nanoseconds).
+ */
+#ifndef STATS_H_   /* Include guard */
+#define STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STATS_BUCKETS 40            // bucket i counts durations below 2^i ns, the last one all longer ones
+#define STATS_BUF_SIZE (32 << 10)   // max. size of a rendered stats page
+
+/** @brief increments a counter, which is only written by the owning worker */
+#define STATS_ADD(var, n) \
+    __atomic_store_n(&(var), __atomic_load_n(&(var), __ATOMIC_RELAXED) + (n), __ATOMIC_RELAXED)
+
+/** @brief the timed phases of a request */
+typedef enum stats_phase {
+    PHASE_ACCEPT,   /** accepting and setting up a connection */
+    PHASE_PARSE,    /** parsing the request header */
+    PHASE_OPEN,     /** looking up, opening (or compressing) the file and preparing the response */
+    PHASE_SEND,     /** sending the response */
+    PHASE_TOTAL,    /** whole request from parsing to the last byte sent */
+    PHASE_COUNT
+} stats_phase;
+
+/** @brief a latency histogram */
+typedef struct stats_histogram {
+    uint64_t count[STATS_BUCKETS];  /** number of durations per bucket */
+    uint64_t sum;                   /** sum of all durations (ns) */
+    uint64_t max;                   /** longest duration (ns) */
+} stats_histogram;
+
+/** @brief the stats of a worker */
+typedef struct stats {
+    uint64_t accepted;              /** accepted connections */
+    uint64_t closed;                /** closed connections */
+    uint64_t requests;              /** requests answered completely */
+    uint64_t responses[6];          /** responses per status class (index 1 to 5) */
+    uint64_t bytes;                 /** bytes sent (header and body) */
+    stats_histogram phase[PHASE_COUNT]; /** latencies per phase */
+} stats;
+
+/**
+ * @brief Returns the current time of the monotonic clock
+ *
+ * @return the time in nanoseconds
+ */
+uint64_t stats_now(void);
+
+/**
+ * @brief Counts the duration of a phase
+ *
+ * @param s the stats of the calling worker
+ * @param p the phase
+ * @param ns the duration in nanoseconds
+ */
+void stats_record(stats* s, stats_phase p, uint64_t ns);
+
+/**
+ * @brief Adds the stats of a (running) worker to a sum
+ *
+ * @param sum the sum, only used by the calling thread
+ * @param s the stats of a worker
+ */
+void stats_add(stats* sum, const stats* s);
+
+/**
+ * @brief Renders stats as a page of plain text or in the Prometheus text format
+ *
+ * @param buf the output buffer
+ * @param size the size of buf, STATS_BUF_SIZE is always sufficient
+ * @param s the stats
+ * @param prometheus use the Prometheus exposition format instead of a human readable table
+ * @return the length of the page (at most size - 1)
+ */
+size_t stats_render(char* buf, size_t size, const stats* s, int prometheus);
+
+#endif // STATS_H_
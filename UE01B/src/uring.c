@@ -0,0 +1,180 @@
+/**
+ * @file uring.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief A minimal io_uring interface on top of the raw system calls
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "uring.h"
+
+/** @brief setup flags, which reduce the work done outside of io_uring_enter (Linux 6.1) */
+#define SETUP_FAST (IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN | \
+    IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN)
+
+/** @brief maps a region of the ring */
+static void* map_ring(int fd, size_t size, off_t offset) {
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+int uring_init(uring* r, unsigned entries) {
+    struct io_uring_params p;
+    memset(r, 0, sizeof(uring));
+    r->fd = -1;
+
+    /* retry without the flags older kernels don't know */
+    int fd = -1;
+    for (int fast = 1; fast >= 0 && fd < 0; fast--) {
+        memset(&p, 0, sizeof(p));
+        p.flags = IORING_SETUP_CQSIZE | (fast ? SETUP_FAST : 0);
+        p.cq_entries = entries * 4;
+        fd = syscall(__NR_io_uring_setup, entries, &p);
+        if (fd < 0 && errno != EINVAL) return -errno;
+    }
+    if (fd < 0) return -errno;
+    if (!(p.features & IORING_FEAT_EXT_ARG)) { // needed for waiting with a timeout
+        close(fd);
+        return -ENOSYS;
+    }
+
+    r->fd = fd;
+    r->features = p.features;
+    r->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_ring_size > r->sq_ring_size) r->sq_ring_size = r->cq_ring_size;
+        r->cq_ring_size = r->sq_ring_size;
+    }
+
+    r->sq_ring = map_ring(fd, r->sq_ring_size, IORING_OFF_SQ_RING);
+    if (r->sq_ring == NULL) goto fail;
+    r->cq_ring = p.features & IORING_FEAT_SINGLE_MMAP ? r->sq_ring :
+        map_ring(fd, r->cq_ring_size, IORING_OFF_CQ_RING);
+    if (r->cq_ring == NULL) goto fail;
+    r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = map_ring(fd, r->sqes_size, IORING_OFF_SQES);
+    if (r->sqes == NULL) goto fail;
+
+    char* sq = r->sq_ring;
+    char* cq = r->cq_ring;
+    r->sq_head = (unsigned*)(sq + p.sq_off.head);
+    r->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+    r->sq_mask = *(unsigned*)(sq + p.sq_off.ring_mask);
+    r->sq_entries = p.sq_entries;
+    r->sq_array = (unsigned*)(sq + p.sq_off.array);
+    r->sqe_tail = *r->sq_tail;
+    r->cq_head = (unsigned*)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+    r->cq_mask = *(unsigned*)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+    /* entries are always submitted in order, so the index array is fixed */
+    for (unsigned i = 0; i < p.sq_entries; i++) r->sq_array[i] = i;
+    return 0;
+
+fail:;
+    int err = errno;
+    uring_exit(r);
+    return -err;
+}
+
+void uring_exit(uring* r) {
+    if (r->sqes) munmap(r->sqes, r->sqes_size);
+    if (r->cq_ring && r->cq_ring != r->sq_ring) munmap(r->cq_ring, r->cq_ring_size);
+    if (r->sq_ring) munmap(r->sq_ring, r->sq_ring_size);
+    if (r->fd >= 0) close(r->fd);
+    memset(r, 0, sizeof(uring));
+    r->fd = -1;
+}
+
+struct io_uring_sqe* uring_sqe(uring* r, uint64_t user_data) {
+    if (r->sqe_tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries) {
+        uring_submit(r, 0, 0);
+        if (r->sqe_tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries) return NULL;
+    }
+
+    struct io_uring_sqe* sqe = &r->sqes[r->sqe_tail++ & r->sq_mask];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->user_data = user_data;
+    return sqe;
+}
+
+int uring_submit(uring* r, unsigned wait, long timeout_ms) {
+    /* publish the prepared entries */
+    __atomic_store_n(r->sq_tail, r->sqe_tail, __ATOMIC_RELEASE);
+    unsigned pending = r->sqe_tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+    if (pending == 0 && wait == 0) return 0;
+
+    struct __kernel_timespec ts = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000 };
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = (uint64_t)(uintptr_t)&ts;
+
+    unsigned flags = IORING_ENTER_EXT_ARG | (wait ? IORING_ENTER_GETEVENTS : 0);
+    int res = syscall(__NR_io_uring_enter, r->fd, pending, wait, flags, &arg, sizeof(arg));
+    return res < 0 ? -errno : res;
+}
+
+struct io_uring_cqe* uring_peek(uring* r) {
+    unsigned head = *r->cq_head;
+    if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) return NULL;
+    return &r->cqes[head & r->cq_mask];
+}
+
+void uring_advance(uring* r, unsigned n) {
+    __atomic_store_n(r->cq_head, *r->cq_head + n, __ATOMIC_RELEASE);
+}
+
+void uring_prep_accept(struct io_uring_sqe* sqe, int fd) {
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+}
+
+void uring_prep_poll(struct io_uring_sqe* sqe, int fd, unsigned events) {
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = events;
+}
+
+void uring_prep_recv(struct io_uring_sqe* sqe, int fd, void* buf, size_t len) {
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = len;
+}
+
+void uring_prep_sendmsg(struct io_uring_sqe* sqe, int fd, const struct msghdr* msg, int flags) {
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)msg;
+    sqe->len = 1;
+    sqe->msg_flags = flags;
+}
+
+void uring_prep_splice(struct io_uring_sqe* sqe, int fd_in, int64_t off_in, int fd_out, unsigned len) {
+    sqe->opcode = IORING_OP_SPLICE;
+    sqe->splice_fd_in = fd_in;
+    sqe->splice_off_in = off_in;
+    sqe->fd = fd_out;
+    sqe->off = (uint64_t)-1;
+    sqe->len = len;
+    sqe->splice_flags = SPLICE_F_MOVE;
+}
+
+void uring_prep_cancel(struct io_uring_sqe* sqe, uint64_t user_data) {
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = user_data;
+}
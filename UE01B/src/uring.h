@@ -0,0 +1,110 @@
+/**
+ * @file uring.h
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief A minimal io_uring interface on top of the raw system calls
+ * @details Operations are prepared in the submission queue without any
+ * system call and are handed to the kernel together with waiting for
+ * completions, so a single io_uring_enter per loop iteration submits all
+ * pending operations and reaps all finished ones. A ring is used by a
+ * single thread only.
+ */
+#ifndef URING_H_   /* Include guard */
+#define URING_H_
+
+#include <linux/io_uring.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#define URING_ENTRIES 1024  // size of the submission queue, the completion queue is four times as large
+
+/** @brief the mapped queues of a ring */
+typedef struct uring {
+    int fd;                         /** the ring, -1 if it isn't set up */
+    unsigned features;              /** IORING_FEAT_* flags of the kernel */
+    unsigned* sq_head;              /** first entry not yet consumed by the kernel */
+    unsigned* sq_tail;              /** entry after the last one published to the kernel */
+    unsigned sq_mask;               /** mask for indices into the submission queue */
+    unsigned* sq_array;             /** indices of the published entries */
+    unsigned sq_entries;            /** size of the submission queue */
+    unsigned sqe_tail;              /** entry after the last prepared one */
+    struct io_uring_sqe* sqes;      /** the submission queue entries */
+    unsigned* cq_head;              /** first completion not yet reaped */
+    unsigned* cq_tail;              /** completion after the last one posted by the kernel */
+    unsigned cq_mask;               /** mask for indices into the completion queue */
+    struct io_uring_cqe* cqes;      /** the completion queue entries */
+    void* sq_ring;                  /** mapping of the submission ring */
+    size_t sq_ring_size;            /** size of sq_ring */
+    void* cq_ring;                  /** mapping of the completion ring, equals sq_ring if shared */
+    size_t cq_ring_size;            /** size of cq_ring */
+    size_t sqes_size;               /** size of the mapping of sqes */
+} uring;
+
+/**
+ * @brief Sets up a ring for the calling thread
+ * @details Completions are only processed when the thread waits for them,
+ * if the kernel supports it. Waiting with a timeout is required.
+ *
+ * @param r the ring
+ * @param entries size of the submission queue
+ * @return 0 on success, a negative errno if io_uring isn't available
+ */
+int uring_init(uring* r, unsigned entries);
+
+/**
+ * @brief Unmaps the queues and closes the ring
+ */
+void uring_exit(uring* r);
+
+/**
+ * @brief Returns a cleared submission queue entry
+ * @details If the queue is full, the prepared entries are submitted first.
+ *
+ * @param r the ring
+ * @param user_data value passed back with the completion
+ * @return the entry, NULL if the kernel didn't accept any entries
+ */
+struct io_uring_sqe* uring_sqe(uring* r, uint64_t user_data);
+
+/**
+ * @brief Submits all prepared entries and waits for completions
+ *
+ * @param r the ring
+ * @param wait min. number of completions to wait for
+ * @param timeout_ms max. time to wait in milliseconds
+ * @return number of entries submitted or a negative errno (-ETIME on timeout, -EINTR)
+ */
+int uring_submit(uring* r, unsigned wait, long timeout_ms);
+
+/**
+ * @brief Returns the next completion without removing it, NULL if there is none
+ */
+struct io_uring_cqe* uring_peek(uring* r);
+
+/**
+ * @brief Removes n completions returned by uring_peek
+ */
+void uring_advance(uring* r, unsigned n);
+
+/** @brief prepares accepting connections until cancelled (one completion per connection) */
+void uring_prep_accept(struct io_uring_sqe* sqe, int fd);
+
+/** @brief prepares a single poll of fd for events */
+void uring_prep_poll(struct io_uring_sqe* sqe, int fd, unsigned events);
+
+/** @brief prepares receiving into buf */
+void uring_prep_recv(struct io_uring_sqe* sqe, int fd, void* buf, size_t len);
+
+/** @brief prepares a gathering send */
+void uring_prep_sendmsg(struct io_uring_sqe* sqe, int fd, const struct msghdr* msg, int flags);
+
+/** @brief prepares moving len bytes from fd_in (at off_in, -1 for pipes) to fd_out */
+void uring_prep_splice(struct io_uring_sqe* sqe, int fd_in, int64_t off_in, int fd_out, unsigned len);
+
+/** @brief prepares cancelling all operations submitted with user_data */
+void uring_prep_cancel(struct io_uring_sqe* sqe, uint64_t user_data);
+
+#endif // URING_H_
@@ -0,0 +1,605 @@
+/**
+ * @file bigint.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Multiplication of large unsigned integers in binary limbs
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#include "bigint.h"
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_addcll) && __has_builtin(__builtin_subcll)
+#define HAVE_BUILTIN_ADDC
+#endif
+#endif
+
+/** @brief a double limb, which holds the product of two limbs */
+__extension__ typedef unsigned __int128 dlimb;
+
+/** @brief value of every character as a hex digit, 0x80 if it isn't one */
+static const unsigned char hex_values[256] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+       0,    1,    2,    3,    4,    5,    6,    7,    8,    9, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80,   10,   11,   12,   13,   14,   15, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80,   10,   11,   12,   13,   14,   15, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+};
+
+/** @brief the hex digit of every value */
+static const char hex_digits[16] = "0123456789ABCDEF";
+
+/**
+ * @brief Adds two limbs and a carry with the carry flag of the CPU
+ *
+ * @param carry the incoming carry (0 or 1)
+ * @param a first limb
+ * @param b second limb
+ * @param r the sum without the carry out
+ * @return the carry out
+ */
+static inline limb add_carry(limb carry, limb a, limb b, limb* r) {
+#if defined(HAVE_BUILTIN_ADDC)
+    unsigned long long out;
+    *r = __builtin_addcll(a, b, carry, &out);
+    return out;
+#elif defined(__x86_64__)
+    unsigned long long s;
+    unsigned char out = _addcarry_u64((unsigned char)carry, a, b, &s);
+    *r = s;
+    return out;
+#else
+    limb s;
+    limb out = __builtin_add_overflow(a, b, &s);
+    out |= __builtin_add_overflow(s, carry, r);
+    return out;
+#endif
+}
+
+/**
+ * @brief Subtracts a limb and a borrow from a limb with the carry flag of the CPU
+ *
+ * @param borrow the incoming borrow (0 or 1)
+ * @param a the minuend
+ * @param b the subtrahend
+ * @param r the difference
+ * @return the borrow out
+ */
+static inline limb sub_borrow(limb borrow, limb a, limb b, limb* r) {
+#if defined(HAVE_BUILTIN_ADDC)
+    unsigned long long out;
+    *r = __builtin_subcll(a, b, borrow, &out);
+    return out;
+#elif defined(__x86_64__)
+    unsigned long long d;
+    unsigned char out = _subborrow_u64((unsigned char)borrow, a, b, &d);
+    *r = d;
+    return out;
+#else
+    limb d;
+    limb out = __builtin_sub_overflow(a, b, &d);
+    out |= __builtin_sub_overflow(d, borrow, r);
+    return out;
+#endif
+}
+
+/**
+ * @brief Adds a[0..m) to r[0..n), m <= n
+ * @return the carry out of r
+ */
+static limb add_in(limb* r, size_t n, const limb* a, size_t m) {
+    limb carry = 0;
+    size_t i = 0;
+    for (; i < m; i++) carry = add_carry(carry, r[i], a[i], &r[i]);
+    for (; i < n && carry; i++) carry = add_carry(carry, r[i], 0, &r[i]);
+    return carry;
+}
+
+/**
+ * @brief Subtracts a[0..m) from r[0..n), m <= n
+ * @return the borrow out of r
+ */
+static limb sub_in(limb* r, size_t n, const limb* a, size_t m) {
+    limb borrow = 0;
+    size_t i = 0;
+    for (; i < m; i++) borrow = sub_borrow(borrow, r[i], a[i], &r[i]);
+    for (; i < n && borrow; i++) borrow = sub_borrow(borrow, r[i], 0, &r[i]);
+    return borrow;
+}
+
+/**
+ * @brief Sets r[0..n] to a[0..n) + b[0..m), m <= n
+ */
+static void add_to(limb* r, const limb* a, size_t n, const limb* b, size_t m) {
+    limb carry = 0;
+    size_t i = 0;
+    for (; i < m; i++) carry = add_carry(carry, a[i], b[i], &r[i]);
+    for (; i < n; i++) carry = add_carry(carry, a[i], 0, &r[i]);
+    r[n] = carry;
+}
+
+/**
+ * @brief Multiplies with the schoolbook method, one row per limb of a
+ *
+ * @param r the product, na + nb limbs
+ */
+static void mul_schoolbook(const limb* a, size_t na, const limb* b, size_t nb, limb* r) {
+    memset(r, 0, (na + nb) * sizeof(limb));
+    for (size_t i = 0; i < na; i++) {
+        if (a[i] == 0) continue;
+        limb carry = 0;
+        for (size_t j = 0; j < nb; j++) {
+            dlimb t = (dlimb)a[i] * b[j] + r[i + j] + carry;
+            r[i + j] = (limb)t;
+            carry = (limb)(t >> 64);
+        }
+        r[i + nb] = carry;
+    }
+}
+
+/**
+ * @brief Returns the number of scratch limbs karatsuba needs for n limbs
+ */
+static size_t karatsuba_scratch(size_t n) {
+    if (n < KARATSUBA_THRESHOLD) return 0;
+    size_t h = n - n / 2;
+    return 4 * (h + 1) + karatsuba_scratch(h + 1);
+}
+
+static void karatsuba_level(const limb* a, const limb* b, size_t n, limb* r, limb* t);
+
+/**
+ * @brief Multiplies with Karatsuba's recursion, below KARATSUBA_THRESHOLD limbs with the schoolbook method
+ *
+ * @param t scratch space, karatsuba_scratch(n) limbs
+ */
+static void karatsuba(const limb* a, const limb* b, size_t n, limb* r, limb* t) {
+    if (n < KARATSUBA_THRESHOLD) mul_schoolbook(a, n, b, n, r);
+    else karatsuba_level(a, b, n, r, t);
+}
+
+/**
+ * @brief Multiplies with one level of Karatsuba's recursion
+ * @details With a = a1 * B^m + a0 and b = b1 * B^m + b0 the product is
+ * z2 * B^2m + z1 * B^m + z0, where z0 = a0 * b0, z2 = a1 * b1 and
+ * z1 = (a0 + a1) * (b0 + b1) - z0 - z2, so three products of half the size
+ * are enough.
+ *
+ * @param a first factor
+ * @param b second factor
+ * @param n number of limbs in a and b
+ * @param r the product, 2 * n limbs
+ * @param t scratch space, 4 * (h + 1) + karatsuba_scratch(h + 1) limbs with h = n - n / 2
+ */
+static void karatsuba_level(const limb* a, const limb* b, size_t n, limb* r, limb* t) {
+    size_t m = n / 2, h = n - m; // a0 and b0 have m limbs, a1 and b1 h >= m limbs
+    limb *sa = t, *sb = sa + h + 1, *z1 = sb + h + 1, *next = z1 + 2 * (h + 1);
+
+    add_to(sa, a + m, h, a, m);
+    add_to(sb, b + m, h, b, m);
+
+    karatsuba(a, b, m, r, next);                    // z0 in the lower half of r
+    karatsuba(a + m, b + m, h, r + 2 * m, next);    // z2 in the upper half of r
+    karatsuba(sa, sb, h + 1, z1, next);
+
+    /* z1 = a0 * b1 + a1 * b0 < 2 * B^n fits into n + 1 limbs */
+    sub_in(z1, 2 * (h + 1), r, 2 * m);
+    sub_in(z1, 2 * (h + 1), r + 2 * m, 2 * h);
+    add_in(r + m, 2 * n - m, z1, n + 1);
+}
+
+/** @brief a product computed by karatsuba_fork */
+typedef struct product {
+    const limb* a;      /** first factor */
+    const limb* b;      /** second factor */
+    size_t n;           /** number of limbs in a and b */
+    limb* r;            /** the product, in memory shared with the parent */
+    int workers;        /** processes, which may compute the product */
+} product;
+
+static int mul_karatsuba(const limb* a, const limb* b, size_t n, limb* r, int split);
+
+/** @brief maps size bytes, which are shared with the children forked later, NULL on failure */
+static void* map_shared(size_t size) {
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+/**
+ * @brief Waits for a child computing a product
+ *
+ * @return 0 if the child succeeded, -1 otherwise
+ */
+static int wait_child(pid_t pid) {
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return -1;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS ? 0 : -1;
+}
+
+/**
+ * @brief Multiplies like karatsuba, the products of a level are computed by child processes
+ *
+ * @param p the product, p->r has to be shared memory
+ * @return 0 on success, -1 on failure
+ */
+static int karatsuba_fork(const product* p) {
+    if (p->workers <= 1 || p->n < PARALLEL_THRESHOLD) return mul_karatsuba(p->a, p->b, p->n, p->r, 0);
+
+    const limb *a = p->a, *b = p->b;
+    size_t n = p->n, m = n / 2, h = n - m;
+    limb* sa = malloc(2 * (h + 1) * sizeof(limb));
+    limb* z1 = map_shared(2 * (h + 1) * sizeof(limb));
+    if (sa == NULL || z1 == NULL) {
+        free(sa);
+        if (z1) munmap(z1, 2 * (h + 1) * sizeof(limb));
+        return -1;
+    }
+    limb* sb = sa + h + 1;
+    add_to(sa, a + m, h, a, m);
+    add_to(sb, b + m, h, b, m);
+
+    /* with two workers, one child computes z0 and the parent the others,
+     * else two children share two thirds of the workers */
+    int w = p->workers, children = w >= 3 ? 2 : 1;
+    product part[3] = {
+        { a, b, m, p->r, children == 2 ? w / 3 : 1 },
+        { a + m, b + m, h, p->r + 2 * m, children == 2 ? w / 3 : 1 },
+        { sa, sb, h + 1, z1, children == 2 ? w - 2 * (w / 3) : 1 },
+    };
+    pid_t pid[2];
+    int ret = 0;
+    for (int i = 0; i < children; i++) {
+        if ((pid[i] = fork()) == 0) _exit(karatsuba_fork(&part[i]) < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+    for (int i = children; i < 3; i++) {
+        if (karatsuba_fork(&part[i]) < 0) ret = -1;
+    }
+    for (int i = 0; i < children; i++) {
+        if (pid[i] < 0) { // couldn't fork, computed here instead
+            if (karatsuba_fork(&part[i]) < 0) ret = -1;
+        } else if (wait_child(pid[i]) < 0) {
+            ret = -1;
+        }
+    }
+
+    if (ret == 0) {
+        sub_in(z1, 2 * (h + 1), p->r, 2 * m);
+        sub_in(z1, 2 * (h + 1), p->r + 2 * m, 2 * h);
+        add_in(p->r + m, 2 * n - m, z1, n + 1);
+    }
+    munmap(z1, 2 * (h + 1) * sizeof(limb));
+    free(sa);
+    return ret;
+}
+
+/** @brief a prime of the number-theoretic transform */
+typedef struct ntt_prime {
+    uint32_t p;         /** the prime, p - 1 is divisible by NTT_MAX_LENGTH */
+    uint32_t g;         /** a primitive root modulo p */
+} ntt_prime;
+
+/** @brief the primes, their product exceeds every coefficient of a product */
+static const ntt_prime ntt_primes[3] = { { 998244353, 3 }, { 167772161, 3 }, { 469762049, 3 } };
+
+/** @brief a prime with the constants of the Montgomery multiplication modulo p */
+typedef struct mont {
+    uint32_t p;         /** the prime */
+    uint32_t pinv;      /** -p^-1 mod 2^32 */
+} mont;
+
+/** @brief computes x * y / 2^32 mod p without a division */
+static inline uint32_t mont_mul(const mont* m, uint32_t x, uint32_t y) {
+    uint64_t t = (uint64_t)x * y;
+    uint32_t q = (uint32_t)t * m->pinv;
+    uint32_t r = (t + (uint64_t)q * m->p) >> 32;
+    return r >= m->p ? r - m->p : r;
+}
+
+/** @brief converts x into the Montgomery form x * 2^32 mod p */
+static uint32_t mont_form(uint32_t x, uint32_t p) {
+    return ((uint64_t)x << 32) % p;
+}
+
+/** @brief computes x^e mod p */
+static uint32_t pow_mod(uint64_t x, uint64_t e, uint32_t p) {
+    uint64_t r = 1;
+    for (x %= p; e > 0; e >>= 1, x = x * x % p) {
+        if (e & 1) r = r * x % p;
+    }
+    return r;
+}
+
+/**
+ * @brief Computes the powers of the roots of unity for every level of a transform
+ *
+ * @param w a primitive n-th root of unity
+ * @param n length of the transform
+ * @param tw the powers of the 2h-th root in Montgomery form start at tw + h, n entries
+ */
+static void ntt_roots(const mont* m, uint32_t w, size_t n, uint32_t* tw) {
+    uint32_t wm = mont_form(w, m->p), x = mont_form(1, m->p);
+    for (size_t j = 0; j < n / 2; j++) {
+        tw[n / 2 + j] = x;
+        x = mont_mul(m, x, wm);
+    }
+    for (size_t h = n / 4; h > 0; h /= 2) {
+        for (size_t j = 0; j < h; j++) tw[h + j] = tw[2 * h + 2 * j];
+    }
+}
+
+/**
+ * @brief Transforms a into bit-reversed order (decimation in frequency)
+ */
+static void ntt_forward(const mont* m, uint32_t* a, size_t n, const uint32_t* tw) {
+    uint32_t p = m->p;
+    for (size_t h = n / 2; h > 0; h /= 2) {
+        for (size_t i = 0; i < n; i += 2 * h) {
+            for (size_t j = 0; j < h; j++) {
+                uint32_t u = a[i + j], v = a[i + j + h];
+                uint32_t s = u + v;
+                a[i + j] = s >= p ? s - p : s;
+                a[i + j + h] = mont_mul(m, u >= v ? u - v : u + p - v, tw[h + j]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Transforms a from bit-reversed order back (decimation in time), without scaling by 1/n
+ */
+static void ntt_inverse(const mont* m, uint32_t* a, size_t n, const uint32_t* tw) {
+    uint32_t p = m->p;
+    for (size_t h = 1; h < n; h *= 2) {
+        for (size_t i = 0; i < n; i += 2 * h) {
+            for (size_t j = 0; j < h; j++) {
+                uint32_t u = a[i + j], v = mont_mul(m, a[i + j + h], tw[h + j]);
+                uint32_t s = u + v;
+                a[i + j] = s >= p ? s - p : s;
+                a[i + j + h] = u >= v ? u - v : u + p - v;
+            }
+        }
+    }
+}
+
+/** @brief splits a into n digits of 32 bits modulo p, padded with zeros */
+static void ntt_digits(const limb* a, size_t na, uint32_t* d, size_t n, uint32_t p) {
+    for (size_t i = 0; i < 2 * na; i++) d[i] = (uint32_t)(a[i / 2] >> (32 * (i & 1))) % p;
+    memset(d + 2 * na, 0, (n - 2 * na) * sizeof(uint32_t));
+}
+
+/**
+ * @brief Computes the cyclic convolution of the 32 bit digits of a and b modulo a prime
+ *
+ * @param prime the prime
+ * @param n length of the transform, a power of two
+ * @param c the convolution, n entries
+ * @return 0 on success, -1 if no memory is available
+ */
+static int ntt_convolve(const ntt_prime* prime, const limb* a, size_t na, const limb* b, size_t nb,
+    size_t n, uint32_t* c) {
+    uint32_t* t = malloc(3 * n * sizeof(uint32_t));
+    if (t == NULL) return -1;
+    uint32_t *d = t + n, *itw = d + n, *tw = t;
+
+    uint32_t p = prime->p;
+    mont m = { p, 1 };
+    for (int i = 0; i < 5; i++) m.pinv *= 2 - p * m.pinv; // Newton's method doubles the correct bits
+    m.pinv = -m.pinv;
+
+    uint32_t w = pow_mod(prime->g, (p - 1) / n, p);
+    ntt_roots(&m, w, n, tw);
+    ntt_roots(&m, pow_mod(w, p - 2, p), n, itw);
+
+    ntt_digits(a, na, c, n, p);
+    ntt_digits(b, nb, d, n, p);
+    ntt_forward(&m, c, n, tw);
+    ntt_forward(&m, d, n, tw);
+
+    /* the products lose a factor 2^32 twice, which scale puts back along with 1/n */
+    uint32_t scale = mont_form(mont_form(pow_mod(n, p - 2, p), p), p);
+    for (size_t i = 0; i < n; i++) c[i] = mont_mul(&m, mont_mul(&m, c[i], d[i]), scale);
+
+    ntt_inverse(&m, c, n, itw);
+    free(t);
+    return 0;
+}
+
+/**
+ * @brief Multiplies with number-theoretic transforms modulo three primes
+ * @details The 32 bit digits of the factors are convolved modulo every prime,
+ * the coefficients are recombined with Garner's algorithm of the Chinese
+ * remainder theorem and their carries are propagated. With several workers,
+ * the convolutions are computed by child processes into shared memory.
+ *
+ * @param r the product, na + nb limbs
+ * @param workers max. number of processes computing at the same time
+ * @return 0 on success, -1 if no memory is available or a child failed
+ */
+static int mul_ntt(const limb* a, size_t na, const limb* b, size_t nb, limb* r, int workers) {
+    size_t len = 2 * (na + nb), n = 2;
+    while (n < len) n *= 2;
+
+    int children = workers >= 3 ? 2 : workers - 1;
+    size_t size = 3 * n * sizeof(uint32_t);
+    uint32_t* c = children > 0 ? map_shared(size) : malloc(size);
+    if (c == NULL) return -1;
+
+    pid_t pid[2];
+    int ret = 0;
+    for (int i = 0; i < children; i++) {
+        if ((pid[i] = fork()) == 0)
+            _exit(ntt_convolve(&ntt_primes[i], a, na, b, nb, n, c + i * n) < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+    for (int i = children; i < 3; i++) {
+        if (ntt_convolve(&ntt_primes[i], a, na, b, nb, n, c + i * n) < 0) ret = -1;
+    }
+    for (int i = 0; i < children; i++) {
+        if (pid[i] < 0) { // couldn't fork, computed here instead
+            if (ntt_convolve(&ntt_primes[i], a, na, b, nb, n, c + i * n) < 0) ret = -1;
+        } else if (wait_child(pid[i]) < 0) {
+            ret = -1;
+        }
+    }
+
+    if (ret == 0) {
+        uint64_t p1 = ntt_primes[0].p, p2 = ntt_primes[1].p, p3 = ntt_primes[2].p;
+        uint64_t inv1 = pow_mod(p1, p2 - 2, p2), inv12 = pow_mod(p1 * p2 % p3, p3 - 2, p3);
+        dlimb carry = 0;
+        for (size_t i = 0; i < len; i++) {
+            /* x = x1 + x2 * p1 + x3 * p1 * p2 with the residues c1, c2 and c3 */
+            uint64_t x1 = c[i], x2 = (c[n + i] + p2 - x1 % p2) % p2 * inv1 % p2;
+            uint64_t x12 = x1 + x2 * p1;
+            uint64_t x3 = (c[2 * n + i] + p3 - x12 % p3) % p3 * inv12 % p3;
+            carry += x12 + (dlimb)x3 * (p1 * p2);
+
+            limb digit = (uint32_t)carry;
+            carry >>= 32;
+            if (i & 1) r[i / 2] |= digit << 32;
+            else r[i / 2] = digit;
+        }
+    }
+    if (children > 0) munmap(c, size);
+    else free(c);
+    return ret;
+}
+
+/**
+ * @brief Multiplies two numbers with the same number of limbs in-process
+ *
+ * @param r the product, 2 * n limbs
+ * @param split set to split the numbers once even below KARATSUBA_THRESHOLD limbs (n >= 2)
+ * @return 0 on success, -1 if no memory is available
+ */
+static int mul_karatsuba(const limb* a, const limb* b, size_t n, limb* r, int split) {
+    size_t h = n - n / 2;
+    size_t scratch = split ? 4 * (h + 1) + karatsuba_scratch(h + 1) : karatsuba_scratch(n);
+    limb* t = NULL;
+    if (scratch > 0 && (t = malloc(scratch * sizeof(limb))) == NULL) return -1;
+    if (split) karatsuba_level(a, b, n, r, t);
+    else karatsuba(a, b, n, r, t);
+    free(t);
+    return 0;
+}
+
+/**
+ * @brief Multiplies two numbers with the same number of limbs with up to workers processes
+ *
+ * @param r the product, 2 * n limbs
+ * @return 0 on success, -1 if no memory is available or a child failed
+ */
+static int mul_balanced(const limb* a, const limb* b, size_t n, limb* r, int workers) {
+    if (workers <= 1 || n < PARALLEL_THRESHOLD) return mul_karatsuba(a, b, n, r, 0);
+
+    limb* shared = map_shared(2 * n * sizeof(limb));
+    if (shared == NULL) return mul_karatsuba(a, b, n, r, 0);
+    product p = { a, b, n, shared, workers };
+    int ret = karatsuba_fork(&p);
+    if (ret == 0) memcpy(r, shared, 2 * n * sizeof(limb));
+    munmap(shared, 2 * n * sizeof(limb));
+    return ret;
+}
+
+size_t bigint_limbs(size_t digits) {
+    return (digits + LIMB_DIGITS - 1) / LIMB_DIGITS;
+}
+
+int bigint_from_hex(const char* hex, size_t digits, limb* a) {
+    unsigned char invalid = 0;
+    for (size_t i = 0, end = digits; end > 0; i++) {
+        /* the digits of limb i, without a branch per digit */
+        size_t begin = end > LIMB_DIGITS ? end - LIMB_DIGITS : 0;
+        limb v = 0;
+        for (size_t k = begin; k < end; k++) {
+            unsigned char d = hex_values[(unsigned char)hex[k]];
+            invalid |= d;
+            v = (v << 4) | (d & 0xF);
+        }
+        a[i] = v;
+        end = begin;
+    }
+    return invalid & 0x80 ? -1 : 0;
+}
+
+void bigint_to_hex(const limb* a, size_t digits, char* hex) {
+    char* p = hex + digits;
+    for (size_t i = 0; p > hex; i++) {
+        limb v = a[i];
+        for (int k = 0; k < LIMB_DIGITS && p > hex; k++, v >>= 4) *--p = hex_digits[v & 0xF];
+    }
+}
+
+size_t bigint_digits(const limb* a, size_t n) {
+    while (n > 0 && a[n - 1] == 0) n--;
+    if (n == 0) return 1;
+    size_t digits = (n - 1) * LIMB_DIGITS;
+    for (limb v = a[n - 1]; v != 0; v >>= 4) digits++;
+    return digits;
+}
+
+int bigint_mul(const limb* a, size_t na, const limb* b, size_t nb, limb* r, int workers) {
+    if (na < nb) {
+        const limb* t = a;
+        a = b;
+        b = t;
+        size_t n = na;
+        na = nb;
+        nb = n;
+    }
+    if (nb < KARATSUBA_THRESHOLD) {
+        mul_schoolbook(b, nb, a, na, r); // one row per limb of the short number
+        return 0;
+    }
+    if (nb >= NTT_THRESHOLD && 2 * (na + nb) <= NTT_MAX_LENGTH) return mul_ntt(a, na, b, nb, r, workers);
+    if (na == nb) return mul_balanced(a, b, nb, r, workers);
+
+    /* a is cut into pieces of nb limbs, so every balanced product is as large
+     * as possible, a last shorter piece is split the same way recursively */
+    limb* t = malloc(2 * nb * sizeof(limb));
+    if (t == NULL) return -1;
+    memset(r, 0, (na + nb) * sizeof(limb));
+    int ret = 0;
+    for (size_t i = 0; i < na && ret == 0; i += nb) {
+        size_t k = na - i < nb ? na - i : nb;
+        if ((ret = bigint_mul(a + i, k, b, nb, t, workers)) == 0) add_in(r + i, na + nb - i, t, k + nb);
+    }
+    free(t);
+    return ret;
+}
+
+int bigint_mul_method(const limb* a, const limb* b, size_t n, limb* r, bigint_method method) {
+    switch (method) {
+        case BIGINT_SCHOOLBOOK:
+            mul_schoolbook(a, n, b, n, r);
+            return 0;
+        case BIGINT_KARATSUBA:
+            return n < 2 ? -1 : mul_karatsuba(a, b, n, r, 1);
+        case BIGINT_NTT:
+            return 4 * n > NTT_MAX_LENGTH ? -1 : mul_ntt(a, n, b, n, r, 1);
+        default:
+            return bigint_mul(a, n, b, n, r, 1);
+    }
+}
@@ -0,0 +1,115 @@
+/**
+ * @file bigint.h
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Multiplication of large unsigned integers in binary limbs
+ * @details Numbers are arrays of 64 bit limbs, least significant limb first.
+ * Products are computed with Karatsuba's recursion, which needs three
+ * instead of four half-size products, and with the schoolbook method below
+ * KARATSUBA_THRESHOLD limbs, where it is faster. The products of the top
+ * levels can be computed by child processes, which return them through
+ * shared memory. From NTT_THRESHOLD limbs on, products are computed with
+ * number-theoretic transforms modulo three primes instead, which are exact
+ * in integer arithmetic. Numbers of different lengths are multiplied in
+ * pieces of the shorter length, so the work depends on the actual lengths
+ * only. The thresholds have been chosen with bigint_bench (make bench).
+ */
+#ifndef BIGINT_H_   /* Include guard */
+#define BIGINT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LIMB_DIGITS 16              // hex digits per limb
+#define KARATSUBA_THRESHOLD 32      // min. number of limbs multiplied with Karatsuba
+#define PARALLEL_THRESHOLD 2048     // min. number of limbs, whose products are computed by child processes
+#define NTT_THRESHOLD 8192          // min. number of limbs multiplied with number-theoretic transforms
+#define NTT_MAX_LENGTH (1 << 23)    // max. number of 32 bit digits of a product computed with transforms
+
+/** @brief a digit of a large number in base 2^64 */
+typedef uint64_t limb;
+
+/** @brief the methods of bigint_mul_method */
+typedef enum bigint_method {
+    BIGINT_AUTO,        /** chosen by the thresholds like bigint_mul */
+    BIGINT_SCHOOLBOOK,  /** one row per limb */
+    BIGINT_KARATSUBA,   /** Karatsuba's recursion, splits at least once */
+    BIGINT_NTT          /** number-theoretic transforms modulo three primes */
+} bigint_method;
+
+/**
+ * @brief Returns the number of limbs needed for a number of hex digits
+ */
+size_t bigint_limbs(size_t digits);
+
+/**
+ * @brief Parses a hex number
+ *
+ * @param hex the hex digits, most significant first (upper or lower case)
+ * @param digits number of digits in hex
+ * @param a the number, bigint_limbs(digits) limbs
+ * @return 0 on success, -1 if hex contains an invalid digit
+ */
+int bigint_from_hex(const char* hex, size_t digits, limb* a);
+
+/**
+ * @brief Formats the lowest digits hex digits of a number, padded with zeros
+ *
+ * @param a the number, at least bigint_limbs(digits) limbs
+ * @param digits number of digits written to hex
+ * @param hex the upper case digits, most significant first (not terminated)
+ */
+void bigint_to_hex(const limb* a, size_t digits, char* hex);
+
+/**
+ * @brief Returns the number of hex digits of a number without leading zeros
+ *
+ * @param a the number
+ * @param n number of limbs in a
+ * @return the number of significant digits, 1 if the number is zero
+ */
+size_t bigint_digits(const limb* a, size_t n);
+
+/**
+ * @brief Multiplies two numbers with up to workers processes
+ * @details Below KARATSUBA_THRESHOLD limbs, the shorter factor is multiplied
+ * with the schoolbook method. From NTT_THRESHOLD limbs on, the 32 bit digits
+ * of the factors are convolved with transforms modulo three primes, which
+ * can be computed by three processes, if the product has at most
+ * NTT_MAX_LENGTH digits. Otherwise, the longer factor is cut into pieces of
+ * the length of the shorter one, which are multiplied with Karatsuba. The
+ * three products of a Karatsuba level are split among the workers: two of
+ * them are computed by forked children, which share the remaining workers
+ * further down, the third one by the calling process. Levels below
+ * PARALLEL_THRESHOLD limbs or with a single worker left are computed
+ * in-process. The children write their products into shared anonymous
+ * mappings, so only binary limbs are exchanged. If a fork fails, the product
+ * is computed by the calling process instead.
+ *
+ * @param a first factor
+ * @param na number of limbs in a
+ * @param b second factor
+ * @param nb number of limbs in b
+ * @param r the product, na + nb limbs (mustn't overlap a or b)
+ * @param workers max. number of processes computing at the same time, 1 to
+ * compute in-process
+ * @return 0 on success, -1 if no memory is available or a child failed
+ */
+int bigint_mul(const limb* a, size_t na, const limb* b, size_t nb, limb* r, int workers);
+
+/**
+ * @brief Multiplies two numbers with the same number of limbs in-process with a given method
+ * @details Used to compare the methods and to choose the thresholds.
+ *
+ * @param a first factor
+ * @param b second factor
+ * @param n number of limbs in a and b
+ * @param r the product, 2 * n limbs (mustn't overlap a or b)
+ * @param method the method
+ * @return 0 on success, -1 if no memory is available or the numbers are too
+ * large for the method
+ */
+int bigint_mul_method(const limb* a, const limb* b, size_t n, limb* r, bigint_method method);
+
+#endif // BIGINT_H_
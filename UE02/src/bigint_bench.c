@@ -0,0 +1,150 @@
+/**
+ * @file bigint_bench.c
+ * @author Maximilian Müller (11810852)
+ * @date 17.10.2026
+ *
+ * @brief Size sweep of the multiplication methods
+ * @details Multiplies random numbers of growing sizes (powers of two and
+ * the sizes in between) with every method, checks that all methods give the
+ * same product and prints the time per product, so the thresholds in
+ * bigint.h can be checked on a machine. Karatsuba splits the numbers at
+ * least once, so comparing it to the schoolbook method measures, from which
+ * size on a level of Karatsuba pays off.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bigint.h"
+
+#define METHODS 4               // number of methods compared
+#define MIN_TIME 2e8            // min. nanoseconds a method is measured for
+#define SCHOOLBOOK_MAX 8192     // max. number of limbs multiplied with the schoolbook method
+
+static char* pname;
+
+/** @brief names of the methods, indexed by bigint_method */
+static const char* method_names[METHODS] = { "auto", "schoolbook", "karatsuba", "ntt" };
+
+/**
+ * @brief Prints the correct usage of the Programm
+ */
+static void usage(void) {
+    fprintf(stderr, "Usage: %s [-n LIMBS]\n"
+        "\t-n max. number of limbs of a factor (default = 65536)\n", pname);
+    exit(EXIT_FAILURE);
+}
+
+/** @brief returns the current time in nanoseconds */
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/** @brief returns a random limb */
+static limb random_limb(void) {
+    limb x = 0;
+    for (int i = 0; i < 4; i++) x = (x << 16) ^ (rand() & 0xFFFF);
+    return x;
+}
+
+/**
+ * @brief Measures the time of a method, repeating it for at least MIN_TIME
+ *
+ * @param r the product, 2 * n limbs
+ * @return nanoseconds per product, a negative value if the method failed
+ */
+static double measure(const limb* a, const limb* b, size_t n, limb* r, bigint_method method) {
+    long reps = 0;
+    double start = now_ns(), ns;
+    do {
+        if (bigint_mul_method(a, b, n, r, method) < 0) return -1;
+        reps++;
+    } while ((ns = now_ns() - start) < MIN_TIME);
+    return ns / reps;
+}
+
+/**
+ * Program entry point.
+ *
+ * @return EXIT_SUCCESS if all methods gave the same products
+ */
+int main(int argc, char *argv[]) {
+    pname = argv[0];
+    long max = 65536;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:")) != -1) {
+        switch (c) {
+            case 'n':
+                max = strtol(optarg, NULL, 10);
+                break;
+            case '?':
+            default:
+                usage();
+        }
+    }
+    if (max < 1 || optind < argc) usage();
+
+    limb *a = malloc(max * sizeof(limb)), *b = malloc(max * sizeof(limb));
+    limb *r[METHODS];
+    int nomem = a == NULL || b == NULL;
+    for (int m = 0; m < METHODS; m++) {
+        if ((r[m] = malloc(2 * max * sizeof(limb))) == NULL) nomem = 1;
+    }
+    if (nomem) {
+        fprintf(stderr, "%s: No memory available\n", pname);
+        exit(EXIT_FAILURE);
+    }
+    srand(time(NULL));
+    for (long i = 0; i < max; i++) {
+        a[i] = random_limb();
+        b[i] = random_limb();
+    }
+
+    printf("%8s %9s", "limbs", "digits");
+    for (int m = 0; m < METHODS; m++) printf(" %12s", method_names[m]);
+    printf("   (ms per product)\n");
+
+    int failures = 0;
+    size_t karatsuba_from = 0, ntt_from = 0;
+    for (size_t n = 8; n <= (size_t)max; n += n & (n - 1) ? n / 3 : n / 2) {
+        double ns[METHODS];
+        printf("%8zu %9zu", n, n * LIMB_DIGITS);
+        for (int m = 0; m < METHODS; m++) {
+            ns[m] = m == BIGINT_SCHOOLBOOK && n > SCHOOLBOOK_MAX ? -1 : measure(a, b, n, r[m], m);
+            if (ns[m] < 0) printf(" %12s", "-");
+            else printf(" %12.4f", ns[m] / 1e6);
+        }
+        for (int m = 1; m < METHODS; m++) {
+            if (ns[m] >= 0 && memcmp(r[0], r[m], 2 * n * sizeof(limb)) != 0) {
+                printf("  %s differs", method_names[m]);
+                failures++;
+            }
+        }
+        printf("\n");
+        fflush(stdout);
+
+        /* the smallest sizes, from which on a method stays faster */
+        if (ns[BIGINT_SCHOOLBOOK] >= 0) {
+            if (ns[BIGINT_KARATSUBA] >= ns[BIGINT_SCHOOLBOOK]) karatsuba_from = 0;
+            else if (karatsuba_from == 0) karatsuba_from = n;
+        }
+        if (ns[BIGINT_NTT] >= 0) {
+            if (ns[BIGINT_NTT] >= ns[BIGINT_KARATSUBA]) ntt_from = 0;
+            else if (ntt_from == 0) ntt_from = n;
+        }
+    }
+
+    printf("karatsuba faster from %zu limbs (KARATSUBA_THRESHOLD %i), ntt faster from %zu limbs (NTT_THRESHOLD %i)\n",
+        karatsuba_from, KARATSUBA_THRESHOLD, ntt_from, NTT_THRESHOLD);
+
+    free(a);
+    free(b);
+    for (int m = 0; m < METHODS; m++) free(r[m]);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}